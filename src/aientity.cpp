@@ -0,0 +1,83 @@
+#include "aientity.h"
+
+#include "densitytargeter.h"
+#include "fleetplacer.h"
+#include "shot.h"
+
+#include <QIcon>
+#include <QTime>
+#include <QTimer>
+
+AIEntity::AIEntity(Sea::Player player, Sea* sea)
+: Entity(player)
+, m_sea(sea)
+, m_targeter(0)
+, m_random(QTime::currentTime().msec() + 1000 * QTime::currentTime().second())
+{
+}
+
+AIEntity::~AIEntity()
+{
+    delete m_targeter;
+}
+
+void AIEntity::start(bool)
+{
+    const QList<unsigned int>& fleet = m_sea->settings().fleet();
+    if (!placeFleet(m_sea, m_player, fleet, m_random)) {
+        qDebug() << "cannot place the whole fleet";
+    }
+
+    delete m_targeter;
+    m_targeter = new DensityTargeter(m_sea->size(), fleet, m_random.next());
+
+    emit ready(m_player);
+}
+
+void AIEntity::startPlaying()
+{
+    scheduleShot();
+}
+
+void AIEntity::hit(Shot* shot)
+{
+    if (shot->player() != m_player && m_sea->canHit(shot->player(), shot->pos())) {
+        HitInfo info = m_sea->hit(shot->pos());
+        shot->execute(info);
+    }
+    else {
+        shot->execute(HitInfo::INVALID);
+    }
+}
+
+void AIEntity::notify(Sea::Player player, const Coord& c, const HitInfo& info)
+{
+    if (player == m_player) {
+        m_targeter->notify(c, info);
+    }
+    scheduleShot();
+}
+
+void AIEntity::scheduleShot()
+{
+    if (m_sea->status() == Sea::PLAYING && m_sea->turn() == m_player) {
+        QTimer::singleShot(MOVE_DELAY, this, SLOT(shootNext()));
+    }
+}
+
+void AIEntity::shootNext()
+{
+    if (m_sea->status() != Sea::PLAYING || m_sea->turn() != m_player) {
+        return;
+    }
+
+    Coord c = m_targeter->next();
+    if (c.valid()) {
+        emit shoot(m_player, c);
+    }
+}
+
+QIcon AIEntity::icon() const
+{
+    return QIcon("roll");
+}
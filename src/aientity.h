@@ -0,0 +1,34 @@
+#ifndef AIENTITY_H
+#define AIENTITY_H
+
+#include "entity.h"
+#include "random.h"
+
+class DensityTargeter;
+
+class AIEntity : public Entity
+{
+Q_OBJECT
+    static const int MOVE_DELAY = 400; // ms
+
+    Sea* m_sea;
+    DensityTargeter* m_targeter;
+    Random m_random;
+
+    void scheduleShot();
+public:
+    AIEntity(Sea::Player player, Sea* sea);
+    ~AIEntity();
+
+    // entity interface
+    virtual void start(bool);
+    virtual void startPlaying();
+    virtual void hit(Shot* shot);
+    virtual void notify(Sea::Player player, const Coord& c, const HitInfo& info);
+
+    virtual QIcon icon() const;
+private slots:
+    void shootNext();
+};
+
+#endif // AIENTITY_H
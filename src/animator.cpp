@@ -13,13 +13,15 @@
 Animator* Animator::m_instance = 0;
 
 Animator::Animator()
+: m_running(false)
+, m_start(0)
 {
     m_group = new AnimationGroup;
-    connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
 }
 
 Animator::~Animator()
 {
+    FrameClock::instance()->unschedule(this);
     delete m_group;
 }
 
@@ -31,17 +33,19 @@ void Animator::add(Animation* a)
 
 void Animator::start()
 {
-    if (!m_timer.isActive()) {
-        m_timer.start(0);
-        m_time.restart();
+    if (!m_running) {
+        m_running = true;
+        m_start = FrameClock::instance()->elapsed();
         m_group->start(0);
+        FrameClock::instance()->schedule(this);
     }
 }
 
 void Animator::stop()
 {
     m_group->stop();
-    m_timer.stop();
+    m_running = false;
+    FrameClock::instance()->unschedule(this);
 }
 
 void Animator::restart()
@@ -50,11 +54,14 @@ void Animator::restart()
     start();
 }
 
-void Animator::tick()
+bool Animator::advanceFrame(qint64 msecs)
 {
-    if (m_group->step(m_time.elapsed())) {
+    // animations may start while the frame is being advanced
+    if (m_group->step(static_cast<int>(qMax<qint64>(0, msecs - m_start)))) {
         stop();
+        return false;
     }
+    return true;
 }
 
 Animator* Animator::instance()
@@ -10,18 +10,23 @@
 #ifndef ANIMATOR_H
 #define ANIMATOR_H
 
-#include <QTimer>
-#include <QTime>
+#include "frameclock.h"
+
+#include <QObject>
 
 class AnimationGroup;
 class Animation;
 
-class Animator : public QObject
+/**
+ * Steps the animations on each frame of the FrameClock, while there
+ * are some.
+ */
+class Animator : public QObject, private FrameClient
 {
 Q_OBJECT
     AnimationGroup* m_group;
-    QTimer m_timer;
-    QTime m_time;
+    bool m_running;
+    qint64 m_start; // clock time the animations started at
     
     static Animator* m_instance;
     Animator();
@@ -34,8 +39,8 @@ public:
     void start();
     void stop();
     void restart();
-private slots:
-    void tick();
+protected:
+    virtual bool advanceFrame(qint64 msecs);
 };
 
 #endif // ANIMATOR_H
@@ -15,27 +15,80 @@
 #include "animation.h"
 #include "welcomescreen.h"
 
-BattleFieldView::BattleFieldView(KGameCanvasWidget* parent, KBSRenderer* renderer, const QString& bgID, int gridSize)
+FieldGrid::FieldGrid(KGameCanvasAbstract* parent, KBSRenderer* renderer)
+: QObject()
+, KGameCanvasPixmap(parent)
+, m_cache(renderer->gridCache())
+{
+    connect(m_cache, SIGNAL(rendered(const QString&, const QPixmap&)),
+            this, SLOT(gridRendered(const QString&, const QPixmap&)));
+}
+
+void FieldGrid::update(KBSRenderer* renderer, const Coord& gridSize, bool visible)
+{
+    if (!visible) {
+        m_key.clear();
+        hide();
+        return;
+    }
+    show();
+
+    QSize size = renderer->size(gridSize.x, gridSize.y);
+    if (renderer->isResizing() && !m_rendered.isNull()) {
+        // like the sprites, until the size settles
+        setPixmap(m_rendered.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+        m_key.clear();
+        return;
+    }
+
+    QString key = GridCache::key(size, gridSize);
+    if (key == m_key) {
+        return;
+    }
+    m_key = key;
+    QPixmap pixmap = m_cache->grid(size, gridSize);
+    if (!pixmap.isNull()) {
+        gridRendered(key, pixmap);
+    }
+}
+
+void FieldGrid::gridRendered(const QString& key, const QPixmap& pixmap)
+{
+    if (key == m_key) {
+        m_rendered = pixmap;
+        setPixmap(pixmap);
+    }
+}
+
+BattleFieldView::BattleFieldView(KGameCanvasWidget* parent, KBSRenderer* renderer, const QString& bgID, const Coord& gridSize)
 : KGameCanvasGroup(parent)
 , m_renderer(renderer)
 , m_factory(this, renderer)
-, m_bgID(bgID)
 , m_gridSize(gridSize)
 , m_impact(0)
 , m_last_hit(0)
 , m_drawGrid(true)
 {
-    m_background_lower = new KGameCanvasPixmap(
-        m_renderer->render(bgID + "-layer1", false, m_gridSize, m_gridSize), this);
+    // the floor only changes with the size of the field
+    m_floor = new KGameCanvasGroup(this);
+    m_floor->setCached(true);
+    m_floor->moveTo(0, 0);
+    m_floor->show();
+
+    m_background_lower = new Sprite(m_floor, m_renderer, m_gridSize, bgID + "-layer1", false);
     m_background_lower->moveTo(0, 0);
     m_background_lower->setOpacity(250);
     m_background_lower->show();
 
-    m_background = new KGameCanvasPixmap(
-        m_renderer->render(bgID + "-layer2", false, m_gridSize, m_gridSize), this);
+    m_grid = new FieldGrid(m_floor, m_renderer);
+    m_grid->update(m_renderer, m_gridSize, m_drawGrid);
+    m_grid->moveTo(0, 0);
+    m_grid->stackOver(m_background_lower);
+
+    m_background = new Sprite(this, m_renderer, m_gridSize, bgID + "-layer2", false);
     m_background->moveTo(0, 0);
     m_background->setOpacity(250);
-    m_background->stackOver(m_background_lower);
+    m_background->stackOver(m_floor);
     m_background->show();
 
     m_screen = new WelcomeScreen(this, parent->font());
@@ -50,7 +103,14 @@ BattleFieldView::BattleFieldView(KGameCanvasWidget* parent, KBSRenderer* rendere
 
 QSize BattleFieldView::size() const
 {
-    return m_renderer->size() * m_gridSize;
+    QSize tile = m_renderer->size();
+    return QSize(tile.width() * m_gridSize.x, tile.height() * m_gridSize.y);
+}
+
+void BattleFieldView::setGridSize(const Coord& gridSize)
+{
+    // the caller updates the view, once the tile size fits the new grid
+    m_gridSize = gridSize;
 }
 
 void BattleFieldView::drawGrid(bool show)
@@ -65,33 +125,17 @@ void BattleFieldView::update()
     m_screen->moveTo(0, 0);
     m_screen->resize(size());
 
-    // update background
-    if(m_drawGrid) {
-        qreal width, height;
-        qreal distw, disth;
-        width = size().width();
-        height = size().height();
-        distw = width / m_gridSize;
-        disth = height / m_gridSize;
-        QPixmap pixgrid = m_renderer->render(m_bgID + "-layer1", false, m_gridSize, m_gridSize);
-        QPainter p;
-        p.begin(&pixgrid);
-        for(int i = 0; i < m_gridSize - 1; i++) {
-            // vertical lines
-            p.drawLine(QPointF((i + 1) * distw, 0.0), QPointF(( i + 1) * distw, height));
-            // horizontal lines
-            p.drawLine(QPointF(0.0, (i + 1) * disth), QPointF(width, (i + 1) * disth));
-        }
-        p.end();
-        m_background_lower->setPixmap(pixgrid);
-    }
-    else {
-        m_background_lower->setPixmap(
-            m_renderer->render(m_bgID + "-layer1", false, m_gridSize, m_gridSize));
-    }
+    // sprites cover whole tiles
+    setIndexCellSize(m_renderer->size().width());
+
+    // update background, the pixmaps follow once rendered
+    m_background_lower->setScale(m_gridSize);
+    m_background_lower->update(m_renderer);
     m_background_lower->moveTo(0, 0);
-    m_background->setPixmap(
-        m_renderer->render(m_bgID + "-layer2", false, m_gridSize, m_gridSize));
+    m_grid->update(m_renderer, m_gridSize, m_drawGrid);
+    m_grid->moveTo(0, 0);
+    m_background->setScale(m_gridSize);
+    m_background->update(m_renderer);
     m_background->moveTo(0, 0);
 
     // update preview
@@ -173,12 +217,12 @@ void BattleFieldView::sink(const Coord& c, Ship* ship)
             else if (s->name().startsWith("hit")) {
                 s->setName("hit-end");
                 s->update(m_renderer);
-                s->stackOver(m_background_lower);
+                s->stackOver(m_floor);
             }
         }
     }
     if (ship_sprite) {
-        ship_sprite->stackOver(m_background_lower);
+        ship_sprite->stackOver(m_floor);
     }
 }
 
@@ -18,22 +18,43 @@
 #include <QMultiHash>
 #include <QTime>
 
+class GridCache;
 class KBSRenderer;
 class Sprite;
 class Ship;
 class WelcomeScreen;
 
+/**
+ * The lines of the grid of a field, over its lower background layer.
+ * Their pixmaps come from the GridCache of the renderer, shared by both
+ * fields, and show once rendered.
+ */
+class FieldGrid : public QObject, public KGameCanvasPixmap
+{
+Q_OBJECT
+    GridCache* m_cache;
+    QString m_key; // grid shown or waited for
+    QPixmap m_rendered;
+public:
+    FieldGrid(KGameCanvasAbstract* parent, KBSRenderer* renderer);
+
+    void update(KBSRenderer* renderer, const Coord& gridSize, bool visible);
+private slots:
+    void gridRendered(const QString& key, const QPixmap& pixmap);
+};
+
 class BattleFieldView : public KGameCanvasGroup
 {
     static const int PREVIEW_OPACITY = 120;
 
-    KGameCanvasPixmap* m_background;
-    KGameCanvasPixmap* m_background_lower;
+    Sprite* m_background;
+    KGameCanvasGroup* m_floor; // lower background and grid, cached
+    FieldGrid* m_grid;
+    Sprite* m_background_lower;
     WelcomeScreen* m_screen;
     KBSRenderer* m_renderer;
     SpriteFactory m_factory;
-    QString m_bgID;
-    int m_gridSize;
+    Coord m_gridSize;
     Sprite* m_impact;
     Sprite* m_last_hit;
     bool m_drawGrid;
@@ -55,9 +76,11 @@ class BattleFieldView : public KGameCanvasGroup
     Sprites m_sprites;
     void addSprite(const Coord& c, Sprite* ship);
 public:
-    BattleFieldView(KGameCanvasWidget* parent, KBSRenderer* renderer, const QString& bgID, int gridSize);
+    BattleFieldView(KGameCanvasWidget* parent, KBSRenderer* renderer, const QString& bgID, const Coord& gridSize);
     QSize size() const;
 
+    void setGridSize(const Coord& gridSize);
+
     void drawGrid(bool show);
     void update();
     
@@ -9,19 +9,25 @@
 
 #include "controller.h"
 
+#include "aientity.h"
 #include "networkentity.h"
 #include "playerentity.h"
 #include "seaview.h"
 #include "shot.h"
 
 
-Controller::Controller(QObject* parent)
+Controller::Controller(QObject* parent, const GameSettings& settings)
 : QObject(parent)
 , m_shot(0)
 , m_ready(0)
 {
     m_ui = 0;
-    m_sea = new Sea(this, Coord(10, 10));
+    m_sea = new Sea(settings);
+}
+
+Controller::~Controller()
+{
+    delete m_sea;
 }
 
 PlayerEntity* Controller::createPlayer(Sea::Player player, SeaView* view,
@@ -44,6 +50,8 @@ NetworkEntity* Controller::createRemotePlayer(Sea::Player player, Protocol* prot
     NetworkEntity* e = new NetworkEntity(player, m_sea, protocol, client);
     setupEntity(e);
     connect(e, SIGNAL(restartRequested()), this, SIGNAL(restartRequested()));
+    connect(e, SIGNAL(settingsChanged(GameSettings)), this, SLOT(changeSettings(GameSettings)));
+    connect(e, SIGNAL(firstMove(int)), this, SLOT(setFirstPlayer(int)));
     if (client) {
         m_sea->switchTurn();
     }
@@ -51,6 +59,13 @@ NetworkEntity* Controller::createRemotePlayer(Sea::Player player, Protocol* prot
     return e;
 }
 
+AIEntity* Controller::createAI(Sea::Player player)
+{
+    AIEntity* e = new AIEntity(player, m_sea);
+    setupEntity(e);
+    return e;
+}
+
 void Controller::setupEntity(Entity* entity)
 {
     entity->setParent(this);
@@ -89,6 +104,7 @@ bool Controller::start(SeaView* view, bool ask)
         setupEntity(m_ui);
     }
 
+    setupStats();
     foreach (Entity* entity, m_entities) {
         entity->start(ask);
     }
@@ -96,6 +112,47 @@ bool Controller::start(SeaView* view, bool ask)
     return true;
 }
 
+void Controller::setupStats()
+{
+    foreach (Entity* entity, m_entities) {
+        entity->stats()->setTargets(m_sea->settings().squares());
+    }
+}
+
+void Controller::changeSettings(const GameSettings& settings)
+{
+    if (settings == m_sea->settings()) {
+        return;
+    }
+
+    if (m_ready > 0 || m_sea->status() != Sea::PLACING_SHIPS) {
+        qDebug() << "game options changed after placing ships";
+        emit gameAbort();
+        return;
+    }
+
+    // start placing ships again, on the new board
+    m_sea->reset(settings);
+    setupStats();
+    foreach (Entity* entity, m_entities) {
+        if (entity != sender()) {
+            entity->start(false);
+        }
+    }
+}
+
+void Controller::setFirstPlayer(int player)
+{
+    if (m_sea->status() != Sea::PLACING_SHIPS) {
+        return;
+    }
+
+    if (m_sea->turn() != player) {
+        m_sea->switchTurn();
+        emit turnChanged(m_sea->turn());
+    }
+}
+
 void Controller::shoot(int player, const Coord& c)
 {
     Entity* entity = findEntity(Sea::opponent(Sea::Player(player)));
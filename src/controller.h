@@ -12,6 +12,7 @@
 
 #include "sea.h"
 
+class AIEntity;
 class Entity;
 class NetworkEntity;
 class UIEntity;
@@ -34,15 +35,18 @@ Q_OBJECT
     void finalizeShot(Sea::Player player, const Coord& c, const HitInfo& info);
     void finalizeGame(Sea::Player winner);
     bool allPlayers() const;
+    void setupStats();
 
 
     friend class Shot;
 public:
-    explicit Controller(QObject* parent);
+    explicit Controller(QObject* parent, const GameSettings& settings = GameSettings());
+    ~Controller();
 
     PlayerEntity* createPlayer(Sea::Player player, SeaView* view,
                                const QString& nick);
     NetworkEntity* createRemotePlayer(Sea::Player player, Protocol* protocol, bool client);
+    AIEntity* createAI(Sea::Player player);
 
     bool start(SeaView* view, bool ask = false);
     Entity* findEntity(Sea::Player) const;
@@ -50,6 +54,8 @@ public:
 public slots:
     void shoot(int player, const Coord& c);
     void ready(int player);
+    void changeSettings(const GameSettings& settings);
+    void setFirstPlayer(int player);
 signals:
     void gameAbort();
     void gameOver(Sea::Player);
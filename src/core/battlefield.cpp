@@ -0,0 +1,209 @@
+/*
+  Copyright (c) 2007 Paolo Capriotti <p.capriotti@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+*/
+
+#include "battlefield.h"
+
+BattleField::BattleField(const Coord& size)
+: m_size(size)
+, m_ship(size.y)
+, m_hit(size.y)
+, m_miss(size.y)
+, m_border(size.y)
+, m_row_mask(BitBoard::span(0, size.x))
+, m_ids(size)
+, m_ships(0)
+{
+    Q_ASSERT(m_size.x <= BitBoard::MAX_SIZE && m_size.y <= BitBoard::MAX_SIZE);
+
+    FOREACH_SQUARE(p, m_ids) {
+        m_ids[p] = 0;
+    }
+}
+
+BattleField::~BattleField()
+{
+    foreach (const FleetEntry& entry, m_fleet) {
+        delete entry.ship;
+    }
+}
+
+void BattleField::addToFleet(Ship* ship, const Coord& pos, int life)
+{
+    Q_ASSERT(m_fleet.size() < MAX_SHIPS);
+    m_fleet.append(FleetEntry(ship, pos, life));
+    quint8 id = m_fleet.size();
+
+    Coord p = pos;
+    for (unsigned int i = 0; i < ship->size(); i++) {
+        m_ids[p] = id;
+        p += ship->increment();
+    }
+
+    Span span = shipSpan(pos, ship->size(), ship->direction());
+    for (int y = span.top; y <= span.bottom; y++) {
+        m_ship.row(y) |= span.bits;
+    }
+}
+
+BattleField::Span BattleField::shipSpan(const Coord& pos, unsigned int size, Ship::Direction direction) const
+{
+    Span res;
+    res.top = pos.y;
+    if (direction == Ship::LEFT_TO_RIGHT) {
+        res.bottom = pos.y;
+        res.bits = BitBoard::span(pos.x, size);
+    }
+    else {
+        res.bottom = pos.y + size - 1;
+        res.bits = BitBoard::span(pos.x, 1);
+    }
+    return res;
+}
+
+BattleField::Span BattleField::neighbours(const Span& span) const
+{
+    // grow by one square on every side, without leaving the board
+    Span res;
+    res.top = qMax(span.top - 1, 0);
+    res.bottom = qMin(span.bottom + 1, m_size.y - 1);
+    res.bits = (span.bits | (span.bits << 1) | (span.bits >> 1)) & m_row_mask;
+    return res;
+}
+
+bool BattleField::valid(const Coord& pos) const
+{
+    return m_ids.valid(pos);
+}
+
+void BattleField::add(int n)
+{
+    m_ships += n;
+}
+
+void BattleField::add(const Coord& pos, Ship* ship)
+{
+    addToFleet(ship, pos, ship->size());
+    m_ships++;
+}
+
+void BattleField::addBorder(const Coord& pos)
+{
+    if (quint8 id = m_ids[pos]) {
+        const FleetEntry& entry = m_fleet[id - 1];
+        Span area = neighbours(shipSpan(entry.pos, entry.size, entry.direction));
+        for (int y = area.top; y <= area.bottom; y++) {
+            m_border.row(y) |= area.bits & ~(m_ship.row(y) | m_hit.row(y) | m_miss.row(y));
+        }
+    }
+}
+
+bool BattleField::canAddShip(const Coord& pos, unsigned int size, Ship::Direction direction) const
+{
+    if (size == 0) {
+        return true;
+    }
+
+    Coord end = pos + Ship::increment(direction) * (size - 1);
+    if (!valid(pos) || !valid(end)) {
+        return false;
+    }
+
+    Span span = shipSpan(pos, size, direction);
+    for (int y = span.top; y <= span.bottom; y++) {
+        if (taken(y) & span.bits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+HitInfo BattleField::hit(const Coord& pos)
+{
+    if (m_hit.test(pos) || m_miss.test(pos) || m_border.test(pos)) {
+        return HitInfo::INVALID;
+    }
+
+    if (!m_ship.test(pos)) {
+        m_miss.set(pos);
+        return HitInfo::MISS;
+    }
+
+    m_hit.set(pos);
+    FleetEntry& entry = m_fleet[m_ids[pos] - 1];
+    entry.ship->decLife();
+
+    HitInfo res(HitInfo::HIT);
+    if (--entry.life == 0)
+    {
+        m_ships--;
+        res.shipDestroyed = entry.ship;
+        res.shipPos = entry.pos;
+    }
+
+    return res;
+}
+
+void BattleField::forceHit(const Coord& pos, const HitInfo& info)
+{
+    switch (info.type) {
+    case HitInfo::HIT:
+        m_hit.set(pos);
+        if (info.shipDestroyed) {
+            addToFleet(info.shipDestroyed, info.shipPos, 0);
+            m_ships--;
+        }
+        break;
+    case HitInfo::MISS:
+        m_miss.set(pos);
+        break;
+    case HitInfo::INVALID:
+        break;
+    }
+}
+
+Element BattleField::at(const Coord& c) const
+{
+    Element res;
+    if (m_hit.test(c)) {
+        res.setType(Element::DEAD);
+    }
+    else if (m_miss.test(c)) {
+        res.setType(Element::MISS);
+    }
+    else if (m_border.test(c)) {
+        res.setType(Element::BORDER);
+    }
+    else if (m_ship.test(c)) {
+        res.setType(Element::ALIVE);
+    }
+    res.setParent(owner(c));
+    return res;
+}
+
+Coord BattleField::find(Ship* ship) const
+{
+    foreach (const FleetEntry& entry, m_fleet) {
+        if (entry.ship == ship) {
+            return entry.pos;
+        }
+    }
+    return Coord::invalid();
+}
+
+bool BattleField::isNearShip(const Coord& pos) const
+{
+    Span area = neighbours(shipSpan(pos, 1, Ship::LEFT_TO_RIGHT));
+    for (int y = area.top; y <= area.bottom; y++) {
+        if (m_ship.row(y) & area.bits) {
+            return true;
+        }
+    }
+    return false;
+}
+
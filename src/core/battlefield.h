@@ -0,0 +1,101 @@
+/*
+  Copyright (c) 2007 Paolo Capriotti <p.capriotti@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+*/
+
+#ifndef BATTLEFIELD_H
+#define BATTLEFIELD_H
+
+#include "bitboard.h"
+#include "ship.h"
+#include "hitinfo.h"
+#include "grid.h"
+
+#include <QVector>
+
+class BattleField
+{
+    Coord m_size;
+
+    // one bit per square for each state
+    BitBoard m_ship;        // square belongs to a ship
+    BitBoard m_hit;         // square has been hit (DEAD)
+    BitBoard m_miss;        // shot into water (MISS)
+    BitBoard m_border;      // marked as border of a ship (BORDER)
+
+    // all squares of a row
+    quint64 m_row_mask;
+
+    // a rectangle of squares: the same bits of rows top to bottom
+    struct Span
+    {
+        int top;
+        int bottom;
+        quint64 bits;
+    };
+
+    // ships on this field, indexed by id - 1
+    struct FleetEntry
+    {
+        Ship* ship;
+        Coord pos;
+        Ship::Direction direction;
+        unsigned int size;
+        int life;
+
+        FleetEntry()
+        : ship(0)
+        {
+        }
+
+        FleetEntry(Ship* ship, const Coord& pos, int life)
+        : ship(ship)
+        , pos(pos)
+        , direction(ship->direction())
+        , size(ship->size())
+        , life(life)
+        {
+        }
+    };
+    QVector<FleetEntry> m_fleet;
+
+    // id of the ship covering each square, 0 for none
+    Grid<quint8> m_ids;
+    unsigned int m_ships;
+
+    Span shipSpan(const Coord& pos, unsigned int size, Ship::Direction direction) const;
+    Span neighbours(const Span& span) const;
+    inline quint64 taken(int y) const
+    {
+        return m_ship.row(y) | m_hit.row(y) | m_miss.row(y) | m_border.row(y);
+    }
+    void addToFleet(Ship* ship, const Coord& pos, int life);
+    inline Ship* owner(const Coord& c) const { return m_ids[c] ? m_fleet[m_ids[c] - 1].ship : 0; }
+
+    Q_DISABLE_COPY(BattleField)
+public:
+    static const int MAX_SHIPS = 255;
+
+    explicit BattleField(const Coord& size);
+    ~BattleField();
+
+    bool valid(const Coord& pos) const;
+
+    void add(const Coord& pos, Ship* ship);
+    void add(int n);
+    void addBorder(const Coord& pos);
+    bool canAddShip(const Coord& pos, unsigned int size, Ship::Direction direction) const;
+    HitInfo hit(const Coord& pos);
+    void forceHit(const Coord& pos, const HitInfo& info);
+    Element at(const Coord& c) const;
+    Coord find(Ship* ship) const;
+    bool isNearShip(const Coord& c) const;
+
+    inline unsigned int ships() const { return m_ships; }
+};
+
+#endif // BATTLEFIELD_H
@@ -0,0 +1,105 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "coord.h"
+
+/**
+ * A set of board squares, packed one 64 bit word per row: bit x of
+ * row y stands for square (x, y).
+ *
+ * Boards up to 64x64 squares fit. A ship, and the squares around it,
+ * span either a few bits of a single row or the same bit of a few
+ * rows, so operations on them touch O(ship size) words whatever the
+ * size of the board.
+ */
+class BitBoard
+{
+public:
+    static const int MAX_SIZE = 64;
+private:
+    int m_height;
+    quint64 m_rows[MAX_SIZE];
+
+    static int popCount(quint64 word);
+public:
+    explicit BitBoard(int height);
+
+    /**
+     * @return the word with bits x to x + n - 1 set
+     */
+    static quint64 span(int x, int n);
+
+    inline int height() const { return m_height; }
+    inline quint64 row(int y) const { Q_ASSERT(y >= 0 && y < m_height); return m_rows[y]; }
+    inline quint64& row(int y) { Q_ASSERT(y >= 0 && y < m_height); return m_rows[y]; }
+    inline const quint64* rows() const { return m_rows; }
+
+    inline bool test(const Coord& c) const { return (row(c.y) >> c.x) & 1; }
+    inline void set(const Coord& c) { row(c.y) |= Q_UINT64_C(1) << c.x; }
+    inline void reset(const Coord& c) { row(c.y) &= ~(Q_UINT64_C(1) << c.x); }
+
+    bool isEmpty() const;
+    int count() const;
+    void clear();
+};
+
+// Implementation
+
+inline BitBoard::BitBoard(int height)
+: m_height(height)
+{
+    Q_ASSERT(height >= 0 && height <= MAX_SIZE);
+    clear();
+}
+
+inline int BitBoard::popCount(quint64 word)
+{
+#ifdef Q_CC_GNU
+    return __builtin_popcountll(word);
+#else
+    int res = 0;
+    for (; word; word &= word - 1) {
+        res++;
+    }
+    return res;
+#endif
+}
+
+inline quint64 BitBoard::span(int x, int n)
+{
+    Q_ASSERT(x >= 0 && n >= 0 && x + n <= 64);
+    if (n == 0) {
+        return 0;
+    }
+    else if (n == 64) {
+        return ~Q_UINT64_C(0);
+    }
+    return ((Q_UINT64_C(1) << n) - 1) << x;
+}
+
+inline bool BitBoard::isEmpty() const
+{
+    quint64 any = 0;
+    for (int y = 0; y < m_height; y++) {
+        any |= m_rows[y];
+    }
+    return any == 0;
+}
+
+inline int BitBoard::count() const
+{
+    int res = 0;
+    for (int y = 0; y < m_height; y++) {
+        res += popCount(m_rows[y]);
+    }
+    return res;
+}
+
+inline void BitBoard::clear()
+{
+    for (int y = 0; y < m_height; y++) {
+        m_rows[y] = 0;
+    }
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,48 @@
+# Game rules, without any dependency on QtGui.
+# Linked statically by the application and by headless tools.
+
+TEMPLATE = lib
+CONFIG += staticlib
+QT = core
+TARGET = battleship-core
+
+DEPENDPATH += .
+INCLUDEPATH += .
+
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+CONFIG(debug, debug|release) {
+    QMAKE_CXXFLAGS += -O0
+    DEFINES += DEBUG
+}
+
+# SSE2 kernels are used whenever the compiler targets SSE2 (always on
+# x86-64); run qmake with CONFIG+=avx2 to build the AVX2 kernels too.
+avx2 {
+    QMAKE_CXXFLAGS += -mavx2
+}
+
+HEADERS += battlefield.h \
+           bitboard.h \
+           coord.h \
+           densitytargeter.h \
+           element.h \
+           fleetplacer.h \
+           gamesettings.h \
+           grid.h \
+           hitinfo.h \
+           placementcounter.h \
+           random.h \
+           sea.h \
+           ship.h
+
+SOURCES += battlefield.cpp \
+           coord.cpp \
+           densitytargeter.cpp \
+           element.cpp \
+           fleetplacer.cpp \
+           gamesettings.cpp \
+           placementcounter.cpp \
+           sea.cpp \
+           ship.cpp
@@ -0,0 +1,235 @@
+#include "densitytargeter.h"
+
+static int directions(unsigned int size)
+{
+    // a single square ship has only one placement per square
+    return size > 1 ? 2 : 1;
+}
+
+static Ship::Direction directionOf(int i)
+{
+    return i == 0 ? Ship::LEFT_TO_RIGHT : Ship::TOP_DOWN;
+}
+
+DensityTargeter::DensityTargeter(const Coord& size, const QList<unsigned int>& fleet, quint32 seed)
+: m_size(size)
+, m_state(size.x * size.y, UNKNOWN)
+, m_score(size.x * size.y, 0)
+, m_random(seed)
+{
+    foreach (unsigned int ship, fleet) {
+        int k = m_sizes.indexOf(ship);
+        if (k == -1) {
+            m_sizes.append(ship);
+            m_remaining.append(1);
+        }
+        else {
+            m_remaining[k]++;
+        }
+    }
+
+    m_counts.resize(m_sizes.size());
+    for (int k = 0; k < m_sizes.size(); k++) {
+        m_counts[k] = QVector<int>(m_state.size(), 0);
+        addPlacements(k, 1);
+        for (int i = 0; i < m_score.size(); i++) {
+            m_score[i] += m_remaining[k] * m_counts[k][i];
+        }
+    }
+}
+
+bool DensityTargeter::legal(const Coord& pos, unsigned int size, Ship::Direction direction) const
+{
+    Coord inc = Ship::increment(direction);
+    if (!valid(pos) || !valid(pos + inc * (size - 1))) {
+        return false;
+    }
+
+    Coord p = pos;
+    for (unsigned int i = 0; i < size; i++) {
+        if (blocked(convert(p))) {
+            return false;
+        }
+        p += inc;
+    }
+    return true;
+}
+
+void DensityTargeter::addPlacements(int sizeIndex, int delta)
+{
+    unsigned int size = m_sizes[sizeIndex];
+    QVector<int>& counts = m_counts[sizeIndex];
+
+    for (int d = 0; d < directions(size); d++) {
+        Coord inc = Ship::increment(directionOf(d));
+        for (Coord pos(0, 0); pos.y < m_size.y; pos.y++)
+        for (pos.x = 0; pos.x < m_size.x; pos.x++) {
+            if (legal(pos, size, directionOf(d))) {
+                Coord p = pos;
+                for (unsigned int i = 0; i < size; i++) {
+                    counts[convert(p)] += delta;
+                    p += inc;
+                }
+            }
+        }
+    }
+}
+
+void DensityTargeter::block(const Coord& c)
+{
+    // remove every placement that was legal until now
+    // and crosses c
+    for (int k = 0; k < m_sizes.size(); k++) {
+        unsigned int size = m_sizes[k];
+        QVector<int>& counts = m_counts[k];
+
+        for (int d = 0; d < directions(size); d++) {
+            Coord inc = Ship::increment(directionOf(d));
+            for (unsigned int offset = 0; offset < size; offset++) {
+                Coord pos = c - inc * offset;
+                if (!legal(pos, size, directionOf(d))) {
+                    continue;
+                }
+
+                Coord p = pos;
+                for (unsigned int i = 0; i < size; i++) {
+                    int index = convert(p);
+                    counts[index]--;
+                    m_score[index] -= m_remaining[k];
+                    p += inc;
+                }
+            }
+        }
+    }
+}
+
+void DensityTargeter::sink(const Coord& pos, unsigned int size, Ship::Direction direction)
+{
+    int k = m_sizes.indexOf(size);
+    if (k != -1 && m_remaining[k] > 0) {
+        m_remaining[k]--;
+        for (int i = 0; i < m_score.size(); i++) {
+            m_score[i] -= m_counts[k][i];
+        }
+    }
+
+    Coord inc = Ship::increment(direction);
+    Coord p = pos;
+    for (unsigned int i = 0; i < size; i++) {
+        if (valid(p) && !blocked(convert(p))) {
+            block(p);
+            m_state[convert(p)] = SUNK;
+            m_hits.removeAll(p);
+        }
+        p += inc;
+    }
+}
+
+void DensityTargeter::notify(const Coord& c, const HitInfo& info)
+{
+    if (!valid(c) || m_state[convert(c)] != UNKNOWN) {
+        return;
+    }
+
+    switch (info.type) {
+    case HitInfo::MISS:
+        block(c);
+        m_state[convert(c)] = MISS;
+        break;
+    case HitInfo::HIT:
+        m_state[convert(c)] = HIT;
+        m_hits.append(c);
+        if (info.shipDestroyed) {
+            sink(info.shipPos, info.shipDestroyed->size(),
+                 info.shipDestroyed->direction());
+        }
+        break;
+    case HitInfo::INVALID:
+        break;
+    }
+}
+
+Coord DensityTargeter::hunt()
+{
+    Coord res = Coord::invalid();
+    int best = -1;
+    int ties = 0;
+    for (int i = 0; i < m_state.size(); i++) {
+        if (m_state[i] != UNKNOWN) {
+            continue;
+        }
+        if (m_score[i] > best) {
+            best = m_score[i];
+            ties = 1;
+            res = Coord(i % m_size.x, i / m_size.x);
+        }
+        else if (m_score[i] == best && m_random.bounded(++ties) == 0) {
+            res = Coord(i % m_size.x, i / m_size.x);
+        }
+    }
+    return res;
+}
+
+Coord DensityTargeter::target()
+{
+    QVector<int> weight(m_state.size(), 0);
+
+    foreach (const Coord& hit, m_hits) {
+        for (int k = 0; k < m_sizes.size(); k++) {
+            if (m_remaining[k] == 0) {
+                continue;
+            }
+
+            unsigned int size = m_sizes[k];
+            for (int d = 0; d < directions(size); d++) {
+                Coord inc = Ship::increment(directionOf(d));
+                for (unsigned int offset = 0; offset < size; offset++) {
+                    Coord pos = hit - inc * offset;
+                    if (!legal(pos, size, directionOf(d))) {
+                        continue;
+                    }
+
+                    int hits = 0;
+                    Coord p = pos;
+                    for (unsigned int i = 0; i < size; i++, p += inc) {
+                        if (m_state[convert(p)] == HIT) {
+                            hits++;
+                        }
+                    }
+
+                    p = pos;
+                    for (unsigned int i = 0; i < size; i++, p += inc) {
+                        if (m_state[convert(p)] == UNKNOWN) {
+                            weight[convert(p)] += m_remaining[k] * hits;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    Coord res = Coord::invalid();
+    int best = 0;
+    int ties = 0;
+    for (int i = 0; i < weight.size(); i++) {
+        if (weight[i] > best) {
+            best = weight[i];
+            ties = 1;
+            res = Coord(i % m_size.x, i / m_size.x);
+        }
+        else if (best > 0 && weight[i] == best && m_random.bounded(++ties) == 0) {
+            res = Coord(i % m_size.x, i / m_size.x);
+        }
+    }
+
+    // the hits cannot be explained by the remaining fleet
+    if (!res.valid()) {
+        return hunt();
+    }
+    return res;
+}
+
+Coord DensityTargeter::next()
+{
+    return m_hits.isEmpty() ? hunt() : target();
+}
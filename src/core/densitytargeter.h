@@ -0,0 +1,74 @@
+#ifndef DENSITYTARGETER_H
+#define DENSITYTARGETER_H
+
+#include "coord.h"
+#include "hitinfo.h"
+#include "random.h"
+#include "ship.h"
+
+#include <QList>
+#include <QVector>
+
+/**
+ * Chooses shots from a probability density over ship placements.
+ *
+ * For every ship size still afloat, the targeter keeps the number of
+ * legal placements covering each square, where a placement is legal if
+ * it avoids every miss and every sunk ship. The counts are updated
+ * incrementally: a miss or a sinking only removes the placements that
+ * cross the newly blocked squares.
+ *
+ * While some hits belong to a ship that is not sunk yet, only the
+ * placements through those hits are considered, weighted by the number
+ * of hits they cover.
+ */
+class DensityTargeter
+{
+    enum State
+    {
+        UNKNOWN,
+        MISS,
+        HIT,
+        SUNK
+    };
+
+    Coord m_size;
+    QVector<unsigned char> m_state;
+
+    // ship sizes in the fleet, and how many of each are still afloat
+    QList<unsigned int> m_sizes;
+    QVector<int> m_remaining;
+
+    // legal placements covering each square, one table per entry of m_sizes
+    QVector<QVector<int> > m_counts;
+
+    // sum of the counts of every ship still afloat
+    QVector<int> m_score;
+
+    QList<Coord> m_hits;
+    Random m_random;
+
+    inline int convert(const Coord& c) const { return c.x + m_size.x * c.y; }
+    inline bool valid(const Coord& c) const
+    {
+        return c.x >= 0 && c.x < m_size.x && c.y >= 0 && c.y < m_size.y;
+    }
+    inline bool blocked(int index) const
+    {
+        return m_state[index] == MISS || m_state[index] == SUNK;
+    }
+
+    bool legal(const Coord& pos, unsigned int size, Ship::Direction direction) const;
+    void addPlacements(int sizeIndex, int delta);
+    void block(const Coord& c);
+    void sink(const Coord& pos, unsigned int size, Ship::Direction direction);
+    Coord hunt();
+    Coord target();
+public:
+    DensityTargeter(const Coord& size, const QList<unsigned int>& fleet, quint32 seed = 1);
+
+    Coord next();
+    void notify(const Coord& c, const HitInfo& info);
+};
+
+#endif // DENSITYTARGETER_H
@@ -9,8 +9,6 @@
 
 #include "element.h"
 
-#include "ship.h"
-
 Element::Element(Type type)
 : m_parent(0)
 , m_type(type)
@@ -34,18 +32,3 @@ bool Element::water() const
     return m_type == WATER;
 }
 
-HitInfo::Type Element::hit()
-{
-    switch (m_type) {
-    case ALIVE:
-        m_type = DEAD;
-        m_parent->decLife();
-        return HitInfo::HIT;
-    case WATER:
-        m_type = MISS;
-        return HitInfo::MISS;
-    default:
-        return HitInfo::INVALID;
-    }
-}
-
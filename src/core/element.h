@@ -10,8 +10,6 @@
 #ifndef ELEMENT_H
 #define ELEMENT_H
 
-#include "hitinfo.h"
-
 class Ship;
 
 class Element
@@ -39,7 +37,6 @@ public:
     
     bool free() const;
     bool water() const;
-    HitInfo::Type hit();
 };
 
 #endif // ELEMENT_H
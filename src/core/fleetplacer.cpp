@@ -0,0 +1,51 @@
+#include "fleetplacer.h"
+
+#include "random.h"
+
+#include <QtAlgorithms>
+
+static const int RANDOM_ATTEMPTS = 100;
+
+bool placeFleet(Sea* sea, Sea::Player player, const QList<unsigned int>& fleet, Random& random)
+{
+    Coord size = sea->size();
+    bool res = true;
+
+    // place the biggest ships first, they are the hardest to fit
+    QList<unsigned int> sizes = fleet;
+    qSort(sizes.begin(), sizes.end(), qGreater<unsigned int>());
+
+    foreach (unsigned int n, sizes) {
+        Ship* ship = new Ship(n, random.bounded(2) ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT);
+
+        bool placed = false;
+        for (int attempt = 0; attempt < RANDOM_ATTEMPTS && !placed; attempt++) {
+            Coord c(random.bounded(size.x), random.bounded(size.y));
+            if (sea->canAddShip(player, c, ship->size(), ship->direction())) {
+                sea->add(player, c, ship);
+                placed = true;
+            }
+        }
+
+        // crowded board: take the first free spot
+        for (int d = 0; d < 2 && !placed; d++) {
+            for (Coord c(0, 0); c.x < size.x && !placed; c.x++)
+            for (c.y = 0; c.y < size.y && !placed; c.y++) {
+                if (sea->canAddShip(player, c, ship->size(), ship->direction())) {
+                    sea->add(player, c, ship);
+                    placed = true;
+                }
+            }
+            if (!placed) {
+                ship->changeDirection();
+            }
+        }
+
+        if (!placed) {
+            delete ship;
+            res = false;
+        }
+    }
+
+    return res;
+}
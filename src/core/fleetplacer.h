@@ -0,0 +1,18 @@
+#ifndef FLEETPLACER_H
+#define FLEETPLACER_H
+
+#include "sea.h"
+
+#include <QList>
+
+class Random;
+
+/**
+ * Places ships of the given sizes at random positions on the field of
+ * a player, checking every position with Sea::canAddShip.
+ *
+ * @return false if some ship did not fit; it is not added then
+ */
+bool placeFleet(Sea* sea, Sea::Player player, const QList<unsigned int>& fleet, Random& random);
+
+#endif // FLEETPLACER_H
@@ -0,0 +1,84 @@
+#include "gamesettings.h"
+
+#include "battlefield.h"
+
+#include <QStringList>
+
+GameSettings::GameSettings()
+: m_size(10, 10)
+{
+    m_fleet << 1 << 2 << 3 << 4;
+}
+
+GameSettings::GameSettings(const Coord& size, const QList<unsigned int>& fleet)
+: m_size(size)
+, m_fleet(fleet)
+{
+}
+
+bool GameSettings::parseSize(const QString& text)
+{
+    QStringList dims = text.split('x');
+    if (dims.size() != 2) {
+        return false;
+    }
+
+    bool okx, oky;
+    Coord size(dims[0].toInt(&okx), dims[1].toInt(&oky));
+    if (!okx || !oky) {
+        return false;
+    }
+    m_size = size;
+    return true;
+}
+
+bool GameSettings::parseFleet(const QString& text)
+{
+    QList<unsigned int> fleet;
+    foreach (const QString& ship, text.split(',')) {
+        bool ok;
+        fleet.append(ship.toUInt(&ok));
+        if (!ok) {
+            return false;
+        }
+    }
+    m_fleet = fleet;
+    return true;
+}
+
+int GameSettings::squares() const
+{
+    int res = 0;
+    foreach (unsigned int ship, m_fleet) {
+        res += ship;
+    }
+    return res;
+}
+
+bool GameSettings::valid() const
+{
+    if (m_size.x < 1 || m_size.y < 1 || m_size.x > MAX_SIZE || m_size.y > MAX_SIZE) {
+        return false;
+    }
+    if (m_fleet.isEmpty() || m_fleet.size() > BattleField::MAX_SHIPS) {
+        return false;
+    }
+
+    unsigned int longest = qMax(m_size.x, m_size.y);
+    foreach (unsigned int ship, m_fleet) {
+        if (ship < 1 || ship > longest) {
+            return false;
+        }
+    }
+    return squares() <= m_size.x * m_size.y;
+}
+
+bool GameSettings::operator==(const GameSettings& other) const
+{
+    return m_size == other.m_size && m_fleet == other.m_fleet;
+}
+
+bool GameSettings::operator!=(const GameSettings& other) const
+{
+    return !operator==(other);
+}
@@ -0,0 +1,59 @@
+#ifndef GAMESETTINGS_H
+#define GAMESETTINGS_H
+
+#include "bitboard.h"
+#include "coord.h"
+
+#include <QList>
+#include <QString>
+
+/**
+ * The parameters of a game: the size of the board, and the sizes of
+ * the ships each player places on it.
+ *
+ * The default is the classic game, a 10x10 board with ships of 1, 2,
+ * 3 and 4 squares.
+ */
+class GameSettings
+{
+    Coord m_size;
+    QList<unsigned int> m_fleet;
+public:
+    static const int MAX_SIZE = BitBoard::MAX_SIZE;
+
+    GameSettings();
+    GameSettings(const Coord& size, const QList<unsigned int>& fleet);
+
+    inline const Coord& size() const { return m_size; }
+    inline const QList<unsigned int>& fleet() const { return m_fleet; }
+    inline int ships() const { return m_fleet.size(); }
+
+    /**
+     * Set the board size from text like "20x15".
+     * @return false, leaving the size untouched, if the text is malformed
+     */
+    bool parseSize(const QString& text);
+
+    /**
+     * Set the fleet from comma separated ship sizes, like "5,4,3,3,2".
+     * @return false, leaving the fleet untouched, if the text is malformed
+     */
+    bool parseFleet(const QString& text);
+
+    /**
+     * @return the number of squares covered by a whole fleet
+     */
+    int squares() const;
+
+    /**
+     * The board must be between 1x1 and MAX_SIZE x MAX_SIZE, every ship
+     * must fit in it, and the fleet must not cover more squares than
+     * the board has.
+     */
+    bool valid() const;
+
+    bool operator==(const GameSettings& other) const;
+    bool operator!=(const GameSettings& other) const;
+};
+
+#endif // GAMESETTINGS_H
@@ -0,0 +1,293 @@
+#include "placementcounter.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// widest vector, in 16 bit lanes
+static const int LANES = 16;
+
+// largest weight whose product with a count (at most MAX_WIDTH)
+// still fits in 16 bits
+static const int MAX_WEIGHT = 1023;
+
+PlacementCounter::PlacementCounter(const Coord& size)
+: m_size(size)
+, m_stride((size.x + LANES - 1) / LANES * LANES)
+, m_kernel(bestKernel())
+, m_blocked(size.y, 0)
+, m_free(size.y * m_stride, 0)
+, m_up(size.y * m_stride, 0)
+, m_down(size.y * m_stride, 0)
+, m_left(size.y * m_stride, 0)
+, m_right(size.y * m_stride, 0)
+, m_acc(size.y * m_stride, 0)
+, m_result(size.x * size.y, 0)
+{
+    Q_ASSERT(size.x <= MAX_WIDTH);
+}
+
+bool PlacementCounter::supported(Kernel kernel)
+{
+    switch (kernel) {
+    case SCALAR:
+        return true;
+    case SSE2:
+#ifdef __SSE2__
+        return true;
+#else
+        return false;
+#endif
+    case AVX2:
+#ifdef __AVX2__
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+PlacementCounter::Kernel PlacementCounter::bestKernel()
+{
+    if (supported(AVX2)) {
+        return AVX2;
+    }
+    else if (supported(SSE2)) {
+        return SSE2;
+    }
+    return SCALAR;
+}
+
+void PlacementCounter::setKernel(Kernel kernel)
+{
+    Q_ASSERT(supported(kernel));
+    m_kernel = kernel;
+}
+
+void PlacementCounter::computeRuns(const quint64* blocked)
+{
+    const int width = m_size.x;
+
+    // free mask and horizontal runs; padding lanes stay at 0
+    for (int y = 0; y < m_size.y; y++) {
+        qint16* free = m_free.data() + y * m_stride;
+        qint16* left = m_left.data() + y * m_stride;
+        qint16* right = m_right.data() + y * m_stride;
+        quint64 row = blocked[y];
+
+        qint16 run = 0;
+        for (int x = 0; x < width; x++) {
+            bool taken = (row >> x) & 1;
+            free[x] = taken ? 0 : -1;
+            run = taken ? 0 : run + 1;
+            left[x] = run;
+        }
+        run = 0;
+        for (int x = width - 1; x >= 0; x--) {
+            run = (row >> x) & 1 ? 0 : run + 1;
+            right[x] = run;
+        }
+    }
+
+    switch (m_kernel) {
+    case AVX2:
+        verticalRunsAVX2();
+        break;
+    case SSE2:
+        verticalRunsSSE2();
+        break;
+    case SCALAR:
+        verticalRunsScalar();
+        break;
+    }
+}
+
+// up = (up of the row above + 1) on free squares, 0 elsewhere;
+// down likewise, from the bottom row
+
+void PlacementCounter::verticalRunsScalar()
+{
+    const int last = (m_size.y - 1) * m_stride;
+    const qint16* free = m_free.constData();
+    qint16* up = m_up.data();
+    qint16* down = m_down.data();
+
+    for (int x = 0; x < m_stride; x++) {
+        up[x] = free[x] & 1;
+        down[last + x] = free[last + x] & 1;
+    }
+    for (int i = m_stride; i <= last; i += m_stride) {
+        for (int x = 0; x < m_stride; x++) {
+            up[i + x] = (up[i + x - m_stride] + 1) & free[i + x];
+        }
+    }
+    for (int i = last - m_stride; i >= 0; i -= m_stride) {
+        for (int x = 0; x < m_stride; x++) {
+            down[i + x] = (down[i + x + m_stride] + 1) & free[i + x];
+        }
+    }
+}
+
+void PlacementCounter::verticalRunsSSE2()
+{
+#ifdef __SSE2__
+    const int last = (m_size.y - 1) * m_stride;
+    const qint16* free = m_free.constData();
+    qint16* up = m_up.data();
+    qint16* down = m_down.data();
+    const __m128i one = _mm_set1_epi16(1);
+
+    for (int x = 0; x < m_stride; x += 8) {
+        __m128i prev = _mm_setzero_si128();
+        for (int i = x; i <= last + x; i += m_stride) {
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + i));
+            prev = _mm_and_si128(_mm_add_epi16(prev, one), f);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(up + i), prev);
+        }
+        prev = _mm_setzero_si128();
+        for (int i = last + x; i >= 0; i -= m_stride) {
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + i));
+            prev = _mm_and_si128(_mm_add_epi16(prev, one), f);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(down + i), prev);
+        }
+    }
+#else
+    verticalRunsScalar();
+#endif
+}
+
+void PlacementCounter::verticalRunsAVX2()
+{
+#ifdef __AVX2__
+    const int last = (m_size.y - 1) * m_stride;
+    const qint16* free = m_free.constData();
+    qint16* up = m_up.data();
+    qint16* down = m_down.data();
+    const __m256i one = _mm256_set1_epi16(1);
+
+    for (int x = 0; x < m_stride; x += 16) {
+        __m256i prev = _mm256_setzero_si256();
+        for (int i = x; i <= last + x; i += m_stride) {
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(free + i));
+            prev = _mm256_and_si256(_mm256_add_epi16(prev, one), f);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(up + i), prev);
+        }
+        prev = _mm256_setzero_si256();
+        for (int i = last + x; i >= 0; i -= m_stride) {
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(free + i));
+            prev = _mm256_and_si256(_mm256_add_epi16(prev, one), f);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(down + i), prev);
+        }
+    }
+#else
+    verticalRunsSSE2();
+#endif
+}
+
+void PlacementCounter::accumulateScalar(const qint16* a, const qint16* b, int size, int weight)
+{
+    quint16* acc = m_acc.data();
+    for (int i = 0; i < m_acc.size(); i++) {
+        int c = qMin<int>(a[i], size) + qMin<int>(b[i], size) - size;
+        if (c > 0) {
+            acc[i] = qMin(acc[i] + c * weight, 0xffff);
+        }
+    }
+}
+
+void PlacementCounter::accumulateSSE2(const qint16* a, const qint16* b, int size, int weight)
+{
+#ifdef __SSE2__
+    const __m128i s = _mm_set1_epi16(size);
+    const __m128i w = _mm_set1_epi16(weight);
+    const __m128i zero = _mm_setzero_si128();
+    quint16* acc = m_acc.data();
+    for (int i = 0; i < m_acc.size(); i += 8) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i c = _mm_sub_epi16(_mm_add_epi16(_mm_min_epi16(va, s), _mm_min_epi16(vb, s)), s);
+        c = _mm_mullo_epi16(_mm_max_epi16(c, zero), w);
+        __m128i* dst = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(dst, _mm_adds_epu16(_mm_loadu_si128(dst), c));
+    }
+#else
+    accumulateScalar(a, b, size, weight);
+#endif
+}
+
+void PlacementCounter::accumulateAVX2(const qint16* a, const qint16* b, int size, int weight)
+{
+#ifdef __AVX2__
+    const __m256i s = _mm256_set1_epi16(size);
+    const __m256i w = _mm256_set1_epi16(weight);
+    const __m256i zero = _mm256_setzero_si256();
+    quint16* acc = m_acc.data();
+    for (int i = 0; i < m_acc.size(); i += 16) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i c = _mm256_sub_epi16(_mm256_add_epi16(_mm256_min_epi16(va, s), _mm256_min_epi16(vb, s)), s);
+        c = _mm256_mullo_epi16(_mm256_max_epi16(c, zero), w);
+        __m256i* dst = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(dst, _mm256_adds_epu16(_mm256_loadu_si256(dst), c));
+    }
+#else
+    accumulateSSE2(a, b, size, weight);
+#endif
+}
+
+void PlacementCounter::accumulate(const qint16* a, const qint16* b, int size, int weight)
+{
+    weight = qMin(weight, MAX_WEIGHT);
+    switch (m_kernel) {
+    case AVX2:
+        accumulateAVX2(a, b, size, weight);
+        break;
+    case SSE2:
+        accumulateSSE2(a, b, size, weight);
+        break;
+    case SCALAR:
+        accumulateScalar(a, b, size, weight);
+        break;
+    }
+}
+
+const QVector<quint16>& PlacementCounter::count(const quint64* miss, const quint64* sunk,
+                                                const quint64* hit, const QVector<int>& remaining)
+{
+    const int width = m_size.x;
+    const int height = m_size.y;
+
+    for (int y = 0; y < height; y++) {
+        m_blocked[y] = miss[y] | sunk[y];
+    }
+    computeRuns(m_blocked.constData());
+
+    m_acc.fill(0);
+    int longest = qMax(width, height);
+    for (int size = 1; size < remaining.size() && size <= longest; size++) {
+        if (remaining[size] <= 0) {
+            continue;
+        }
+        accumulate(m_up.constData(), m_down.constData(), size, remaining[size]);
+
+        // a single square is the same placement in both directions
+        if (size > 1) {
+            accumulate(m_left.constData(), m_right.constData(), size, remaining[size]);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        quint64 shot = m_blocked[y] | hit[y];
+        const quint16* acc = m_acc.constData() + y * m_stride;
+        quint16* result = m_result.data() + y * width;
+        for (int x = 0; x < width; x++) {
+            result[x] = (shot >> x) & 1 ? 0 : acc[x];
+        }
+    }
+
+    return m_result;
+}
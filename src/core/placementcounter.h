@@ -0,0 +1,78 @@
+#ifndef PLACEMENTCOUNTER_H
+#define PLACEMENTCOUNTER_H
+
+#include "coord.h"
+
+#include <QVector>
+
+/**
+ * Counts, for every square, the legal placements of the remaining
+ * fleet that cover it.
+ *
+ * Boards are given as one 64 bit word per row, bit x standing for
+ * column x, so boards up to 64 squares wide are supported. A placement
+ * is legal when it avoids every miss and every sunk square; hits of
+ * ships still afloat do not block placements. Squares that have already
+ * been shot at get a count of 0.
+ *
+ * The count of placements of a ship of size s through a square that
+ * has a free squares above it (itself included) and b below it is
+ * max(0, min(a, s) + min(b, s) - s), and likewise horizontally. The
+ * run lengths are computed once; the formula is then evaluated for
+ * every ship size with SSE2 or AVX2 on 16 bit lanes when available.
+ */
+class PlacementCounter
+{
+public:
+    enum Kernel
+    {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+    static const int MAX_WIDTH = 64;
+private:
+    Coord m_size;
+    int m_stride;
+    Kernel m_kernel;
+
+    QVector<quint64> m_blocked;
+
+    // -1 on free squares, 0 on blocked squares and padding
+    QVector<qint16> m_free;
+
+    // free run lengths through each square, including the square itself
+    QVector<qint16> m_up;
+    QVector<qint16> m_down;
+    QVector<qint16> m_left;
+    QVector<qint16> m_right;
+
+    QVector<quint16> m_acc;
+    QVector<quint16> m_result;
+
+    void computeRuns(const quint64* blocked);
+    void verticalRunsScalar();
+    void verticalRunsSSE2();
+    void verticalRunsAVX2();
+    void accumulateScalar(const qint16* a, const qint16* b, int size, int weight);
+    void accumulateSSE2(const qint16* a, const qint16* b, int size, int weight);
+    void accumulateAVX2(const qint16* a, const qint16* b, int size, int weight);
+    void accumulate(const qint16* a, const qint16* b, int size, int weight);
+public:
+    explicit PlacementCounter(const Coord& size);
+
+    static bool supported(Kernel kernel);
+    static Kernel bestKernel();
+    void setKernel(Kernel kernel);
+    inline Kernel kernel() const { return m_kernel; }
+
+    /**
+     * @param miss, sunk, hit one word per row
+     * @param remaining number of ships afloat, indexed by ship size
+     * @return counts, indexed by x + y * width
+     */
+    const QVector<quint16>& count(const quint64* miss, const quint64* sunk,
+                                  const quint64* hit, const QVector<int>& remaining);
+};
+
+#endif // PLACEMENTCOUNTER_H
@@ -0,0 +1,37 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <QtGlobal>
+
+/**
+ * Small xorshift generator. Unlike qrand() it carries its own state,
+ * so games can be replayed from a seed and run on several threads.
+ */
+class Random
+{
+    quint32 m_state;
+public:
+    explicit Random(quint32 seed = 1)
+    : m_state(seed * 2654435761u + 0x9e3779b9u)
+    {
+        if (!m_state) {
+            m_state = 1;
+        }
+    }
+
+    inline quint32 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // uniform in [0, n)
+    inline int bounded(int n)
+    {
+        return int((quint64(next()) * n) >> 32);
+    }
+};
+
+#endif // RANDOM_H
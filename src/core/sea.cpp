@@ -11,14 +11,13 @@
 
 #include "battlefield.h"
 
-Sea::Sea(QObject* parent, const Coord& size)
-: QObject(parent)
-, m_size(size)
+Sea::Sea(const GameSettings& settings)
+: m_settings(settings)
 , m_turn(PLAYER_A)
 , m_status(PLACING_SHIPS)
 {
-    m_fields[0] = new BattleField(this, m_size);
-    m_fields[1] = new BattleField(this, m_size);
+    m_fields[0] = new BattleField(size());
+    m_fields[1] = new BattleField(size());
 }
 
 Sea::~Sea()
@@ -27,6 +26,16 @@ Sea::~Sea()
 	delete m_fields[1];
 }
 
+void Sea::reset(const GameSettings& settings)
+{
+    delete m_fields[0];
+    delete m_fields[1];
+    m_settings = settings;
+    m_fields[0] = new BattleField(size());
+    m_fields[1] = new BattleField(size());
+    m_status = PLACING_SHIPS;
+}
+
 bool Sea::canAddShip(Player p, const Coord& pos, int size, Ship::Direction direction) const
 {
     if (m_status != PLACING_SHIPS) {
@@ -58,8 +67,7 @@ bool Sea::canHit(Player p, const Coord& pos) const
     if (!otherField()->valid(pos)) {
         return false;
     }
-    Element& e = otherField()->get(pos);
-    return e.free();
+    return otherField()->at(pos).free();
 }
 
 HitInfo Sea::hit(const Coord& pos)
@@ -85,7 +93,7 @@ void Sea::checkGameOver()
     }
 }
 
-const Element& Sea::at(Sea::Player player, const Coord& c) const
+Element Sea::at(Sea::Player player, const Coord& c) const
 {
     return m_fields[player]->at(c);
 }
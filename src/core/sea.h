@@ -10,16 +10,14 @@
 #ifndef Sea_H
 #define Sea_H
 
+#include "gamesettings.h"
 #include "hitinfo.h"
 #include "ship.h"
 
-#include <QObject>
-
 class BattleField;
 
-class Sea : public QObject
+class Sea
 {
-Q_OBJECT
 public:
     enum Status
     {
@@ -35,7 +33,7 @@ public:
         NO_PLAYER = -1
     };
 private:
-    Coord m_size;
+    GameSettings m_settings;
     Player m_turn;
     BattleField* m_fields[2];
     Status m_status;
@@ -44,9 +42,17 @@ private:
     inline BattleField* otherField() const { return m_fields[opponent(m_turn)]; }
     
     void checkGameOver();
+
+    Q_DISABLE_COPY(Sea)
 public:
-    Sea(QObject* parent, const Coord& size);
+    explicit Sea(const GameSettings& settings);
     ~Sea();
+
+    /**
+     * Start over with empty fields, placing ships for a new game, possibly
+     * with different settings. Whose turn it is stays as it was.
+     */
+    void reset(const GameSettings& settings);
     
     bool canAddShip(Player p, const Coord& pos, int size, Ship::Direction direction) const;
     void add(Player p, int n);
@@ -57,7 +63,7 @@ public:
     void forceHit(const Coord& pos, const HitInfo& info);
     void startPlaying();
     void abort(Player p);
-    const Element& at(Sea::Player player, const Coord& pos) const;
+    Element at(Sea::Player player, const Coord& pos) const;
     bool valid(Sea::Player, const Coord& pos) const;
     void switchTurn();
     bool isNearShip(Sea::Player, const Coord& pos) const;
@@ -65,7 +71,8 @@ public:
     inline Status status() const { return m_status; }
     inline Player turn() const { return m_turn; }
     static Player opponent(Player p);
-    inline Coord size() const { return m_size; }
+    inline Coord size() const { return m_settings.size(); }
+    inline const GameSettings& settings() const { return m_settings; }
 };
 
 #endif // Sea_H
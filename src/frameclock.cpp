@@ -0,0 +1,104 @@
+#include "frameclock.h"
+
+FrameClock* FrameClock::m_instance = 0;
+
+FrameClock::FrameClock()
+: m_interval(1000 / FRAME_RATE)
+, m_next(0)
+, m_ticking(false)
+{
+    m_time.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+FrameClock* FrameClock::instance()
+{
+    if (!m_instance) {
+        m_instance = new FrameClock;
+    }
+    return m_instance;
+}
+
+void FrameClock::schedule(FrameClient* client)
+{
+    if (!m_clients.contains(client)) {
+        m_clients.append(client);
+    }
+    if (m_ticking) {
+        if (!m_current.contains(client)) {
+            m_current.append(client);
+        }
+    }
+    else if (!m_timer.isActive()) {
+        // the first frame is due now, the next ones follow at the frame rate
+        m_next = elapsed();
+        m_timer.start(0);
+    }
+}
+
+void FrameClock::unschedule(FrameClient* client)
+{
+    m_clients.removeAll(client);
+    int i = m_current.indexOf(client);
+    if (i != -1) {
+        m_current[i] = 0;
+    }
+    if (m_clients.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+void FrameClock::setFrameRate(int fps)
+{
+    m_interval = qMax(1, 1000 / qMax(1, fps));
+}
+
+int FrameClock::frameRate() const
+{
+    return 1000 / m_interval;
+}
+
+bool FrameClock::isActive() const
+{
+    return m_ticking || m_timer.isActive();
+}
+
+qint64 FrameClock::elapsed() const
+{
+    return m_time.elapsed();
+}
+
+void FrameClock::tick()
+{
+    qint64 msecs = elapsed();
+    m_ticking = true;
+    m_current = m_clients;
+    m_clients.clear();
+
+    // clients scheduled meanwhile are appended, and advanced too
+    for (int i = 0; i < m_current.size(); i++) {
+        FrameClient* client = m_current[i];
+        if (client && client->advanceFrame(msecs) && !m_clients.contains(client)) {
+            m_clients.append(client);
+        }
+    }
+    for (int i = 0; i < m_current.size(); i++) {
+        if (m_current[i]) {
+            m_current[i]->paintFrame();
+        }
+    }
+
+    m_current.clear();
+    m_ticking = false;
+
+    if (!m_clients.isEmpty()) {
+        // frames that could not be kept up with are dropped, rather than
+        // being ticked one after the other
+        qint64 now = elapsed();
+        do {
+            m_next += m_interval;
+        } while (m_next <= now);
+        m_timer.start(static_cast<int>(m_next - now));
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * Something that changes from frame to frame, paced by the FrameClock.
+ */
+class FrameClient
+{
+public:
+    virtual ~FrameClient() { }
+
+    /**
+     * Move on to the time of the frame, in milliseconds since the clock
+     * was created. Every client is advanced before any is painted.
+     * @return Whether the client needs the next frame too.
+     */
+    virtual bool advanceFrame(qint64 msecs) = 0;
+
+    /**
+     * Show what changed while advancing the frame.
+     */
+    virtual void paintFrame() { }
+};
+
+/**
+ * The clock driving every animation of the application. It ticks at a
+ * fixed frame rate while some client asks for frames, and stops as soon
+ * as none does. Each tick advances all scheduled clients at the same
+ * time, and then paints them.
+ */
+class FrameClock : public QObject
+{
+Q_OBJECT
+    QTimer m_timer;
+    QElapsedTimer m_time; // monotonic, unlike QTime
+    int m_interval;
+    qint64 m_next; // time of the next frame
+    bool m_ticking;
+
+    QList<FrameClient*> m_clients;
+    QList<FrameClient*> m_current; // clients of the frame being ticked
+
+    static FrameClock* m_instance;
+    FrameClock();
+public:
+    static const int FRAME_RATE = 60;
+
+    static FrameClock* instance();
+
+    /**
+     * Advance and paint a client on the next frame. Clients scheduled
+     * while a frame is advanced get that frame.
+     */
+    void schedule(FrameClient* client);
+
+    /**
+     * Stop ticking a client, which has to be done before deleting it.
+     */
+    void unschedule(FrameClient* client);
+
+    void setFrameRate(int fps);
+    int frameRate() const;
+
+    /**
+     * Whether a frame is being ticked, or will be.
+     */
+    bool isActive() const;
+
+    /**
+     * Milliseconds since the clock was created.
+     */
+    qint64 elapsed() const;
+private slots:
+    void tick();
+};
+
+#endif // FRAMECLOCK_H
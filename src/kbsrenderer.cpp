@@ -9,16 +9,139 @@
 
 #include "kbsrenderer.h"
 
+#include "kgamerenderer.h"
+
+#include <QDebug>
 #include <QPainter>
-#include <QSvgRenderer>
+#include <QRunnable>
+
+// elements drawn on a tile, ships aside
+static const char* const TILE_ELEMENTS[] = {
+    "hit", "hit-end", "hit-after", "water", "water-impact", 0
+};
+
+// elements covering a whole field
+static const char* const FIELD_ELEMENTS[] = {
+    "background-layer1", "background-layer2",
+    "background2-layer1", "background2-layer2", 0
+};
+
+// icons of the labels and stats widgets, of a fixed size
+static const char* const ICON_ELEMENTS[] = {
+    "score_mouse", "score_ai", "score_network", "water-impact", "hit", 0
+};
+static const int ICON_SIZE = 32;
+
+static QString shipElement(int size)
+{
+    return QString("ship%1-view").arg(size);
+}
+
+// checking that the element exists caches that too
+static int prerenderElement(KGameRenderer* renderer, const QString& name, const QSize& size)
+{
+    return renderer->spriteExists(name) && renderer->prerenderSprite(name, size) ? 1 : 0;
+}
+
+class GridJob : public QRunnable
+{
+    GridCache* m_cache;
+    QString m_key;
+    QSize m_size;
+    Coord m_gridSize;
+public:
+    GridJob(GridCache* cache, const QString& key, const QSize& size, const Coord& gridSize)
+    : m_cache(cache)
+    , m_key(key)
+    , m_size(size)
+    , m_gridSize(gridSize)
+    {
+    }
+
+    virtual void run()
+    {
+        // painting on images is safe outside of the GUI thread
+        QImage image(m_size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(0);
+
+        qreal width = m_size.width();
+        qreal height = m_size.height();
+        qreal distw = width / m_gridSize.x;
+        qreal disth = height / m_gridSize.y;
+        QPainter p;
+        p.begin(&image);
+        for (int i = 0; i < m_gridSize.x - 1; i++) {
+            // vertical lines
+            p.drawLine(QPointF((i + 1) * distw, 0.0), QPointF((i + 1) * distw, height));
+        }
+        for (int i = 0; i < m_gridSize.y - 1; i++) {
+            // horizontal lines
+            p.drawLine(QPointF(0.0, (i + 1) * disth), QPointF(width, (i + 1) * disth));
+        }
+        p.end();
+
+        QMetaObject::invokeMethod(m_cache, "jobFinished", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_key), Q_ARG(QImage, image));
+    }
+};
+
+GridCache::GridCache(QObject* parent)
+: QObject(parent)
+, m_pixmaps(CACHE_SIZE)
+{
+    // grids are cheap, and only one size is needed at a time
+    m_pool.setMaxThreadCount(1);
+}
+
+GridCache::~GridCache()
+{
+    // jobs talk back to the cache
+    m_pool.waitForDone();
+}
+
+QString GridCache::key(const QSize& size, const Coord& gridSize)
+{
+    return QString("grid_%1x%2_%3x%4")
+        .arg(size.width()).arg(size.height())
+        .arg(gridSize.x).arg(gridSize.y);
+}
+
+QPixmap GridCache::grid(const QSize& size, const Coord& gridSize)
+{
+    if (size.isEmpty() || gridSize.x <= 0 || gridSize.y <= 0) {
+        return QPixmap();
+    }
+
+    QString k = key(size, gridSize);
+    if (QPixmap* pixmap = m_pixmaps.object(k)) {
+        return *pixmap;
+    }
+    if (!m_pending.contains(k)) {
+        m_pending.insert(k);
+        m_pool.start(new GridJob(this, k, size, gridSize));
+    }
+    return QPixmap();
+}
+
+void GridCache::jobFinished(const QString& key, const QImage& image)
+{
+    m_pending.remove(key);
+    QPixmap pixmap = QPixmap::fromImage(image);
+    m_pixmaps.insert(key, new QPixmap(pixmap),
+                     qMax(1, pixmap.width() * pixmap.height() * 4 / 1024));
+    emit rendered(key, pixmap);
+}
 
-KBSRenderer::KBSRenderer(const QString& path)
+KBSRenderer::KBSRenderer(const QString& path, unsigned cacheSize)
+: m_resizing(false)
 {
-    m_renderer = new QSvgRenderer(path, 0);
+    m_renderer = new KGameRenderer(path, cacheSize);
+    m_grids = new GridCache;
 }
 
 KBSRenderer::~KBSRenderer()
 {
+    delete m_grids;
     delete m_renderer;
 }
 
@@ -29,10 +152,17 @@ void KBSRenderer::resize(int sz)
 
 void KBSRenderer::resize(const QSize& sz)
 {
-    if (m_size != sz) {
-        m_size = sz;
-        m_cache.clear();
-    }
+    m_size = sz;
+}
+
+void KBSRenderer::setResizing(bool resizing)
+{
+    m_resizing = resizing;
+}
+
+bool KBSRenderer::isResizing() const
+{
+    return m_resizing;
 }
 
 QSize KBSRenderer::size() const
@@ -40,43 +170,55 @@ QSize KBSRenderer::size() const
     return m_size;
 }
 
-QPixmap KBSRenderer::render(const PixmapData& data, const QSize& sz)
+QSize KBSRenderer::size(int xScale, int yScale) const
+{
+    return QSize(m_size.width() * xScale, m_size.height() * yScale);
+}
+
+QPixmap KBSRenderer::render(const QString& id, const QSize& size)
+{
+    if (!m_renderer->spriteExists(id)) {
+        qDebug() << "no element" << id << "\n";
+        return QPixmap();
+    }
+    return m_renderer->spritePixmap(id, size);
+}
+
+int KBSRenderer::prerender(const QList<int>& tileSizes, const Coord& gridSize)
 {
-    if (!m_cache.contains(data)) {
-        if (!m_renderer->elementExists(data.name)) {
-            qDebug() << "no element" << data.name << "\n";
-            return QPixmap();
+    int started = 0;
+    for (int i = 0; ICON_ELEMENTS[i]; i++) {
+        started += prerenderElement(m_renderer, ICON_ELEMENTS[i], QSize(ICON_SIZE, ICON_SIZE));
+    }
+
+    foreach (int tile, tileSizes) {
+        if (tile <= 0) {
+            continue;
+        }
+        for (int i = 0; TILE_ELEMENTS[i]; i++) {
+            started += prerenderElement(m_renderer, TILE_ELEMENTS[i], QSize(tile, tile));
+        }
+        for (int i = 0; FIELD_ELEMENTS[i]; i++) {
+            started += prerenderElement(m_renderer, FIELD_ELEMENTS[i],
+                QSize(tile * gridSize.x, tile * gridSize.y));
         }
-        QImage tmp(sz, QImage::Format_ARGB32_Premultiplied);
-        tmp.fill(0);
-        {
-            QSize renderSize = sz;
-
-            QPainter p(&tmp);
-            if (data.rotated) {
-                qDebug() << "rotating" << data.name;
-                p.translate(QPoint(sz.width(), 0));
-                p.rotate(90);
-                renderSize = QSize(sz.height(), sz.width());
-            }
-
-            m_renderer->render(&p, data.name, QRectF(QPointF(0, 0), renderSize));
+        // ships are rendered lying, whatever their direction
+        for (int size = 1; m_renderer->spriteExists(shipElement(size)); size++) {
+            started += prerenderElement(m_renderer, shipElement(size), QSize(tile * size, tile));
         }
-        m_cache[data] = QPixmap::fromImage(tmp);
     }
 
-    return m_cache.value(data);
+    return started;
 }
 
-QPixmap KBSRenderer::render(const QString& id, bool rotated, int xScale, int yScale)
+KGameRenderer* KBSRenderer::renderer() const
 {
-    return render(PixmapData(id, rotated),
-        QSize(m_size.width() * xScale, m_size.height() * yScale));
+    return m_renderer;
 }
 
-QPixmap KBSRenderer::render(const QString& id, const QSize& size)
+GridCache* KBSRenderer::gridCache() const
 {
-    return render(PixmapData(id, false), size);
+    return m_grids;
 }
 
 
@@ -93,25 +235,3 @@ QPoint KBSRenderer::toReal(const Coord& c) const
 {
     return QPoint(c.x * m_size.width(), c.y * m_size.height());
 }
-
-KBSRenderer::PixmapData::PixmapData(const QString& name, bool rotated)
-: name(name)
-, rotated(rotated)
-{
-}
-
-bool KBSRenderer::PixmapData::operator==(const PixmapData& other) const
-{
-    return other.name == name &&
-            other.rotated == rotated;
-}
-
-uint qHash(const KBSRenderer::PixmapData& data) {
-    QString s = data.name;
-    if (data.rotated) {
-        s += "__rotated";
-    }
-    return qHash(s);
-}
-
-
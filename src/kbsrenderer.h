@@ -12,60 +12,131 @@
 
 #include "ship.h"
 
-#include <QHash>
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QObject>
 #include <QPixmap>
+#include <QSet>
 #include <QString>
+#include <QThreadPool>
 
-class QSvgRenderer;
+class KGameRenderer;
+
+/**
+  * Pixmaps of the lines of field grids, transparent elsewhere, for each
+  * field and grid size. They are painted in a background thread, and the
+  * most recent ones are kept, so that both fields share them.
+  */
+class GridCache : public QObject
+{
+Q_OBJECT
+    QCache<QString, QPixmap> m_pixmaps;
+    QSet<QString> m_pending;
+    QThreadPool m_pool;
+public:
+    /**
+      * Size of the cache, in kilobytes.
+      */
+    static const int CACHE_SIZE = 8192;
+
+    GridCache(QObject* parent = 0);
+    ~GridCache();
+
+    static QString key(const QSize& size, const Coord& gridSize);
+
+    /**
+      * Return a grid if it is cached, otherwise start painting it and
+      * return a null pixmap. rendered() is emitted once it is painted.
+      */
+    QPixmap grid(const QSize& size, const Coord& gridSize);
+private slots:
+    void jobFinished(const QString& key, const QImage& image);
+signals:
+    void rendered(const QString& key, const QPixmap& pixmap);
+};
 
 /**
   * Class to render KBattleShip graphical elements.
+  *
+  * Elements drawn at the tile size are served to KGameRendererClients
+  * such as Sprite, which set their size from size(int, int), and get
+  * their pixmaps as they are rendered. The KGameRenderer keeps them in
+  * its caches, for each size.
   */
 class KBSRenderer
 {
-    struct PixmapData {
-        QString name;
-        bool rotated;
-        bool operator==(const PixmapData& other) const;
-
-        PixmapData(const QString& name, bool rotated);
-    };
-    friend uint qHash(const PixmapData&);
-    typedef QHash<PixmapData, QPixmap> Cache; // use QCache maybe?
 public:
     /**
-      * Create a new renderer instance. Each instance has a different cache.
+      * Size of the disk cache of the theme, in megabytes.
+      */
+    static const unsigned CACHE_SIZE = 16;
+
+    /**
+      * Create a new renderer instance. Each instance has a different
+      * pixmap cache, but instances rendering the same theme share a disk
+      * cache, with other processes too.
       */
-    KBSRenderer(const QString& path);
+    KBSRenderer(const QString& path, unsigned cacheSize = CACHE_SIZE);
 
     ~KBSRenderer();
 
     /**
-      * Set a new size for the elements. Invalidate cache.
+      * Set a new size for the tiles. Clients have to be given their new
+      * size, see size(int, int).
       */
     void resize(int sz);
     void resize(const QSize& sz);
 
     /**
-      * Return current pixmap size.
+      * Tell clients that the tile size keeps changing, so that they
+      * stretch the pixmaps they have instead of asking for new ones,
+      * until they are updated once resizing is over.
+      */
+    void setResizing(bool resizing);
+    bool isResizing() const;
+
+    /**
+      * Return current tile size.
       */
     QSize size() const;
 
     /**
-      * Render an item ensuring it is in the cache.
+      * Return the size of an element covering the given number of tiles.
+      */
+    QSize size(int xScale, int yScale) const;
+
+    /**
+      * Render an item of a fixed size, waiting for it if it is not cached.
       */
-    QPixmap render(const QString& id, bool rotated = false, int xScale = 1, int yScale = 1);
     QPixmap render(const QString& id, const QSize& sz);
 
+    /**
+      * Render every element of the theme, for fields of the given size
+      * with tiles of each of the given sizes, into the disk cache in
+      * background threads, so that they are not rendered on demand later.
+      * Elements already cached are skipped.
+      * @return The number of elements being rendered.
+      */
+    int prerender(const QList<int>& tileSizes, const Coord& gridSize);
+
+    /**
+      * The renderer doing the work, and keeping the disk cache.
+      */
+    KGameRenderer* renderer() const;
+
+    /**
+      * The grids drawn over the fields.
+      */
+    GridCache* gridCache() const;
+
     Coord toLogical(const QPoint& p) const;
     QPoint toReal(const Coord& p) const;
-protected:
-    QPixmap render(const PixmapData& data, const QSize& sz);
 private:
-    QSvgRenderer* m_renderer;
+    KGameRenderer* m_renderer;
+    GridCache* m_grids;
     QSize m_size;
-
-    Cache m_cache;
+    bool m_resizing;
 };
 
 #endif // KBSRENDERER_H
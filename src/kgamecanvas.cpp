@@ -29,11 +29,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kgamecanvas.h"
 
 #include <QApplication>
+#include <QHash>
 #include <QPaintEvent>
 #include <QPainter>
 #include <QRegion>
+#include <QSet>
 #include <QTime>
 #include <QTimer>
+#include <QtAlgorithms>
 
 /*
   TODO:
@@ -44,10 +47,99 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DEBUG_DONT_MERGE_UPDATES 0
 #define DEBUG_CANVAS_PAINTS      0
 
+/*
+    KGameCanvasIndex
+*/
+class KGameCanvasIndex {
+  int m_cell_size;
+  QHash<quint64, QList<KGameCanvasItem*> > m_cells;
+  QHash<KGameCanvasItem*, QRect> m_rects;
+
+  static quint64 key(int x, int y) {
+    return (quint64(quint32(y)) << 32) | quint32(x);
+  }
+
+  int cell(int c) const {
+    return c >= 0 ? c / m_cell_size : -((-c + m_cell_size - 1) / m_cell_size);
+  }
+
+  void insert(KGameCanvasItem* el, const QRect& r) {
+    m_rects.insert(el, r);
+    for(int y=cell(r.top());y<=cell(r.bottom());y++)
+      for(int x=cell(r.left());x<=cell(r.right());x++)
+        m_cells[key(x, y)].append(el);
+  }
+
+  void take(KGameCanvasItem* el, const QRect& r) {
+    for(int y=cell(r.top());y<=cell(r.bottom());y++)
+      for(int x=cell(r.left());x<=cell(r.right());x++) {
+        QHash<quint64, QList<KGameCanvasItem*> >::iterator c = m_cells.find(key(x, y));
+        if(c == m_cells.end())
+          continue;
+        c.value().removeOne(el);
+        if(c.value().isEmpty())
+          m_cells.erase(c);
+      }
+    m_rects.remove(el);
+  }
+
+public:
+  KGameCanvasIndex()
+  : m_cell_size(64) {}
+
+  void setCellSize(int size) {
+    if(size <= 0 || size == m_cell_size)
+      return;
+
+    QHash<KGameCanvasItem*, QRect> rects = m_rects;
+    m_cells.clear();
+    m_rects.clear();
+    m_cell_size = size;
+    for(QHash<KGameCanvasItem*, QRect>::const_iterator i = rects.constBegin();
+          i != rects.constEnd(); ++i)
+      insert(i.key(), i.value());
+  }
+
+  /* an empty rect removes the item */
+  void update(KGameCanvasItem* el, const QRect& r) {
+    QHash<KGameCanvasItem*, QRect>::const_iterator i = m_rects.constFind(el);
+    if(i != m_rects.constEnd()) {
+      if(i.value() == r)
+        return;
+      take(el, i.value());
+    }
+    if(!r.isEmpty())
+      insert(el, r);
+  }
+
+  void remove(KGameCanvasItem* el) {
+    update(el, QRect());
+  }
+
+  /* the items intersecting the region, in no particular order */
+  QList<KGameCanvasItem*> itemsIn(const QRegion& reg) const {
+    QSet<KGameCanvasItem*> found;
+    foreach(const QRect& r, reg.rects()) {
+      for(int y=cell(r.top());y<=cell(r.bottom());y++)
+        for(int x=cell(r.left());x<=cell(r.right());x++) {
+          QHash<quint64, QList<KGameCanvasItem*> >::const_iterator c = m_cells.constFind(key(x, y));
+          if(c == m_cells.constEnd())
+            continue;
+          foreach(KGameCanvasItem* el, c.value())
+            if(m_rects.value(el).intersects(r))
+              found.insert(el);
+        }
+    }
+    return found.toList();
+  }
+};
+
 /*
     KGameCanvasAbstract
 */
-KGameCanvasAbstract::KGameCanvasAbstract() {
+KGameCanvasAbstract::KGameCanvasAbstract()
+: m_index(new KGameCanvasIndex)
+, m_restacked(false) {
 
 }
 
@@ -55,6 +147,64 @@ KGameCanvasAbstract::~KGameCanvasAbstract() {
    //Note: this does not delete the items, be sure not to leak memory!
    for(int i=0;i<m_items.size();i++)
      m_items[i]->m_canvas = NULL;
+   delete m_index;
+}
+
+void KGameCanvasAbstract::setIndexCellSize(int size) {
+  m_index->setCellSize(size);
+}
+
+void KGameCanvasAbstract::updateChangedItems() {
+  // items changed while updating others are updated as well
+  while(!m_changed_items.isEmpty()) {
+    KGameCanvasItem *el = m_changed_items.takeFirst();
+
+    if(el->m_changed)
+      el->updateChanges();
+  }
+}
+
+bool KGameCanvasAbstract::stackedUnder(const KGameCanvasItem* a, const KGameCanvasItem* b) {
+  return a->m_stack < b->m_stack;
+}
+
+void KGameCanvasAbstract::paintItems(QPainter* p, const QRect& prect, const QRegion& preg,
+                                     const QPoint& delta, double cumulative_opacity) {
+  if(m_restacked) {
+    for(int i=0;i<m_items.size();i++)
+      m_items[i]->m_stack = i;
+    m_restacked = false;
+  }
+
+  QList<KGameCanvasItem*> items = m_index->itemsIn(preg.translated(-delta));
+  qSort(items.begin(), items.end(), stackedUnder);
+
+  // from the top, until opaque items cover the whole region
+  QRegion left = preg;
+  int bottom = items.size();
+  for(int i=items.size()-1;i>=0 && !left.isEmpty();i--) {
+    KGameCanvasItem *el = items[i];
+    QRect r = el->rect().translated(delta);
+
+    if( !el->m_visible || !prect.intersects( r ) ) {
+      items[i] = NULL;
+      continue;
+    }
+    el->m_last_rect = r;
+    if( !left.contains( r ) ) {
+      items[i] = NULL;
+      continue;
+    }
+
+    if(el->m_opaque && cumulative_opacity*el->m_opacity >= 254.5)
+      left -= r;
+    bottom = i;
+  }
+
+  for(int i=bottom;i<items.size();i++) {
+    if(items[i])
+      items[i]->paintInternal(p, prect, preg, delta, cumulative_opacity);
+  }
 }
 
 KGameCanvasItem* KGameCanvasAbstract::itemAt(const QPoint &pt) const {
@@ -84,8 +234,7 @@ QList<KGameCanvasItem*> KGameCanvasAbstract::itemsAt(const QPoint &pt) const {
 */
 class KGameCanvasWidgetPrivate {
 public:
-  QTimer m_anim_timer;
-  QTime m_anim_time;
+  qint64 m_anim_start;
   bool m_pending_update;
   QRegion m_pending_update_reg;
 
@@ -104,17 +253,16 @@ public:
 KGameCanvasWidget::KGameCanvasWidget(QWidget* parent)
 : QWidget(parent)
 , priv(new KGameCanvasWidgetPrivate()) {
-  priv->m_anim_time.start();
-  connect(&priv->m_anim_timer, SIGNAL(timeout()), this, SLOT(processAnimations()));
+  priv->m_anim_start = FrameClock::instance()->elapsed();
 }
 
 KGameCanvasWidget::~KGameCanvasWidget() {
+  FrameClock::instance()->unschedule(this);
   delete priv;
 }
 
 void KGameCanvasWidget::ensureAnimating() {
-  if(!priv->m_anim_timer.isActive() )
-      priv->m_anim_timer.start();
+  FrameClock::instance()->schedule(this);
 }
 
 void KGameCanvasWidget::ensurePendingUpdate() {
@@ -125,17 +273,20 @@ void KGameCanvasWidget::ensurePendingUpdate() {
 #if DEBUG_DONT_MERGE_UPDATES
   updateChanges();
 #else //DEBUG_DONT_MERGE_UPDATES
-  QTimer::singleShot( 0, this, SLOT(updateChanges()) );
+  // while something animates, changes are painted with its next frame
+  if(FrameClock::instance()->isActive())
+    FrameClock::instance()->schedule(this);
+  else
+    QTimer::singleShot( 0, this, SLOT(updateChanges()) );
 #endif //DEBUG_DONT_MERGE_UPDATES
 }
 
 void KGameCanvasWidget::updateChanges() {
-  for(int i=0;i<m_items.size();i++) {
-    KGameCanvasItem *el = m_items.at(i);
+  // already painted with a frame
+  if(!priv->m_pending_update)
+    return;
 
-    if(el->m_changed)
-      el->updateChanges();
-  }
+  updateChangedItems();
   priv->m_pending_update = false;
 
 #if DEBUG_CANVAS_PAINTS
@@ -176,28 +327,13 @@ void KGameCanvasWidget::paintEvent(QPaintEvent *event) {
 #endif //DEBUG_CANVAS_PAINTS
 
   {QPainter p(this);
-  QRect evr = event->rect();
-  QRegion evreg = event->region();
-
-  for(int i=0;i<m_items.size();i++) {
-    KGameCanvasItem *el = m_items.at(i);
-    if( el->m_visible && evr.intersects( el->rect() )
-        && evreg.contains( el->rect() ) ) {
-      el->m_last_rect = el->rect();
-      el->paintInternal(&p, evr, evreg, QPoint(), 1.0 );
-    }
-  }}
+  paintItems(&p, event->rect(), event->region(), QPoint(), 1.0);}
 
   QApplication::syncX();
 }
 
-void KGameCanvasWidget::processAnimations() {
-  if(m_animated_items.empty() ) {
-    priv->m_anim_timer.stop();
-    return;
-  }
-
-  int tm = priv->m_anim_time.elapsed();
+bool KGameCanvasWidget::advanceFrame(qint64 msecs) {
+  int tm = static_cast<int>(qMax<qint64>(0, msecs - priv->m_anim_start));
 
   // The list MUST be copied, because it could be modified calling advance.
   // After all since it is implicitly shared the copy will not happen unless
@@ -208,16 +344,19 @@ void KGameCanvasWidget::processAnimations() {
     el->advance(tm);
   }
 
-  if(m_animated_items.empty() )
-    priv->m_anim_timer.stop();
+  return !m_animated_items.empty();
+}
+
+void KGameCanvasWidget::paintFrame() {
+  updateChanges();
 }
 
 void KGameCanvasWidget::setAnimationDelay(int d) {
-  priv->m_anim_timer.setInterval(d);
+  FrameClock::instance()->setFrameRate(1000 / qMax(1, d));
 }
 
 int KGameCanvasWidget::mSecs() {
-  return priv->m_anim_time.elapsed();
+  return static_cast<int>(FrameClock::instance()->elapsed() - priv->m_anim_start);
 }
 
 KGameCanvasWidget* KGameCanvasWidget::topLevelCanvas() {
@@ -234,16 +373,24 @@ QPoint KGameCanvasWidget::canvasPosition() const {
 KGameCanvasItem::KGameCanvasItem(KGameCanvasAbstract* KGameCanvas)
 : m_visible(false)
 , m_animated(false)
+, m_opaque(false)
 , m_opacity(255)
+, m_stack(0)
 , m_pos(0,0)
 , m_canvas(KGameCanvas)
 , m_changed(false) {
-  if(m_canvas) m_canvas->m_items.append(this);
+  if(m_canvas) {
+    m_canvas->m_items.append(this);
+    m_canvas->m_restacked = true;
+  }
 }
 
 KGameCanvasItem::~KGameCanvasItem() {
   if(m_canvas) {
     m_canvas->m_items.removeAll(this);
+    m_canvas->m_index->remove(this);
+    if(m_changed)
+      m_canvas->m_changed_items.removeAll(this);
     if(m_animated)
       m_canvas->m_animated_items.removeAll(this);
     if(m_visible)
@@ -252,6 +399,8 @@ KGameCanvasItem::~KGameCanvasItem() {
 }
 
 void KGameCanvasItem::changed() {
+  if(m_canvas && !m_changed)
+    m_canvas->m_changed_items.append(this);
   m_changed = true;
 
   //even if m_changed was already true we cannot optimiza away this call, because maybe the
@@ -269,6 +418,12 @@ void KGameCanvasItem::updateChanges() {
       m_canvas->invalidate(rect());
   }
   m_changed = false;
+  updateIndex();
+}
+
+void KGameCanvasItem::updateIndex() {
+  if(m_canvas)
+    m_canvas->m_index->update(this, m_visible ? rect() : QRect());
 }
 
 QPixmap *KGameCanvasItem::transparence_pixmap_cache = NULL;
@@ -341,14 +496,19 @@ void KGameCanvasItem::putInCanvas(KGameCanvasAbstract *c) {
     if(m_visible)
       m_canvas->invalidate(m_last_rect, false); //invalidate the previously drawn rectangle
     m_canvas->m_items.removeAll(this);
+    m_canvas->m_index->remove(this);
+    if(m_changed)
+      m_canvas->m_changed_items.removeAll(this);
     if(m_animated)
       m_canvas->m_animated_items.removeAll(this);
   }
 
   m_canvas = c;
+  m_changed = false;
 
   if(m_canvas) {
     m_canvas->m_items.append(this);
+    m_canvas->m_restacked = true;
     if(m_animated) {
       m_canvas->m_animated_items.append(this);
       m_canvas->ensureAnimating();
@@ -364,8 +524,10 @@ void KGameCanvasItem::setVisible(bool v) {
 
   m_visible = v;
   if(m_canvas) {
-    if(!v)
+    if(!v) {
       m_canvas->invalidate(m_last_rect, false);
+      m_canvas->m_index->remove(this);
+    }
     else
       changed();
   }
@@ -429,6 +591,7 @@ void KGameCanvasItem::raise()
     int old_pos = m_canvas->m_items.indexOf(this);
     m_canvas->m_items.removeAt(old_pos);
     m_canvas->m_items.append(this);
+    m_canvas->m_restacked = true;
     if(m_visible)
         updateAfterRestack(old_pos, m_canvas->m_items.size()-1);
 }
@@ -441,6 +604,7 @@ void KGameCanvasItem::lower()
     int old_pos = m_canvas->m_items.indexOf(this);
     m_canvas->m_items.removeAt(old_pos);
     m_canvas->m_items.prepend(this);
+    m_canvas->m_restacked = true;
 
     if(m_visible)
         updateAfterRestack(old_pos, 0);
@@ -465,6 +629,7 @@ void KGameCanvasItem::stackOver(KGameCanvasItem* ref)
     m_canvas->m_items.removeAt(old_pos);
     i = m_canvas->m_items.indexOf(ref);
     m_canvas->m_items.insert(i+1,this);
+    m_canvas->m_restacked = true;
 
     if(m_visible)
         updateAfterRestack(old_pos, i+1);
@@ -490,6 +655,7 @@ void KGameCanvasItem::stackUnder(KGameCanvasItem* ref)
     m_canvas->m_items.removeAt(old_pos);
     i = m_canvas->m_items.indexOf(ref);
     m_canvas->m_items.insert(i,this);
+    m_canvas->m_restacked = true;
 
     if(m_visible)
         updateAfterRestack(old_pos, i);
@@ -520,7 +686,8 @@ QPoint KGameCanvasItem::absolutePosition() const
 KGameCanvasGroup::KGameCanvasGroup(KGameCanvasAbstract* KGameCanvas)
 : KGameCanvasItem(KGameCanvas)
 , KGameCanvasAbstract()
-, m_child_rect_changed(true) {
+, m_child_rect_changed(true)
+, m_cached(false) {
 
 }
 
@@ -542,13 +709,9 @@ void KGameCanvasGroup::ensurePendingUpdate() {
 void KGameCanvasGroup::updateChanges() {
   if(!m_changed)
     return;
-  for(int i=0;i<m_items.size();i++) {
-    KGameCanvasItem *el = m_items.at(i);
-
-    if(el->m_changed)
-      el->updateChanges();
-  }
+  updateChangedItems();
   m_changed = false;
+  updateIndex();
 }
 
 void KGameCanvasGroup::changed() {
@@ -561,6 +724,8 @@ void KGameCanvasGroup::changed() {
 }
 
 void KGameCanvasGroup::invalidate(const QRect& r, bool translate) {
+  if(m_cached)
+    m_cache_dirty |= translate ? r : r.translated(-canvasPosition());
   if(m_canvas)
     m_canvas->invalidate(translate ? r.translated(m_pos) : r, translate);
   if(!m_changed)
@@ -568,6 +733,8 @@ void KGameCanvasGroup::invalidate(const QRect& r, bool translate) {
 }
 
 void KGameCanvasGroup::invalidate(const QRegion& r, bool translate) {
+  if(m_cached)
+    m_cache_dirty |= translate ? r : r.translated(-canvasPosition());
   if(m_canvas)
     m_canvas->invalidate(translate ? r.translated(m_pos) : r, translate);
   if(!m_changed)
@@ -592,23 +759,72 @@ void KGameCanvasGroup::advance(int msecs) {
 
 void KGameCanvasGroup::paintInternal(QPainter* p, const QRect& prect,
           const QRegion& preg, const QPoint& delta, double cumulative_opacity) {
+  if(m_cached) {
+    paintCached(p, prect, delta, cumulative_opacity);
+    return;
+  }
+
   cumulative_opacity *= (m_opacity/255.0);
 
   QPoint adelta = delta;
   adelta += m_pos;
   p->translate(m_pos);
+  paintItems(p, prect, preg, adelta, cumulative_opacity);
+  p->translate(-m_pos);
+}
 
-  for(int i=0;i<m_items.size();i++) {
-    KGameCanvasItem *el = m_items.at(i);
-    QRect r = el->rect().translated(adelta);
+void KGameCanvasGroup::paintCached(QPainter* p, const QRect& prect,
+          const QPoint& delta, double cumulative_opacity) {
+  QRect cr = rect();
+  QRect lr = cr.translated(-m_pos); // in the coordinates of the children
+  if(lr.isEmpty())
+    return;
 
-    if( el->m_visible && prect.intersects( r ) && preg.contains( r ) ) {
-      el->m_last_rect = r;
-      el->paintInternal(p,prect,preg,adelta,cumulative_opacity);
-    }
+  if(lr != m_cache_rect) {
+    /* see getTransparenceCache */
+    m_cache = QPixmap::fromImage( QImage( lr.size(), QImage::Format_ARGB32 ) );
+    m_cache_rect = lr;
+    m_cache_dirty = lr;
   }
 
-  p->translate(-m_pos);
+  QPoint adelta = delta;
+  adelta += m_pos;
+
+  /* paint again what the children changed */
+  m_cache_dirty &= lr;
+  if(!m_cache_dirty.isEmpty()) {
+    QPainter cp(&m_cache);
+    cp.translate(-lr.topLeft());
+    cp.setClipRegion(m_cache_dirty);
+    cp.setCompositionMode(QPainter::CompositionMode_Source);
+    cp.fillRect(m_cache_dirty.boundingRect(), Qt::transparent);
+    cp.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    QRegion dirty = m_cache_dirty.translated(adelta);
+    paintItems(&cp, dirty.boundingRect(), dirty, adelta, 1.0);
+    m_cache_dirty = QRegion();
+  }
+
+  int opacity = int(cumulative_opacity*m_opacity + 0.5);
+  QRect area = prect & cr.translated(delta);
+  if(opacity <= 0 || area.isEmpty())
+    return;
+
+  p->setOpacity(opacity/255.0);
+  p->drawPixmap(area.translated(-delta), m_cache, area.translated(-delta - cr.topLeft()));
+  p->setOpacity(1.0);
+}
+
+void KGameCanvasGroup::setCached(bool c) {
+  if(m_cached == c)
+    return;
+
+  m_cached = c;
+  m_cache = QPixmap();
+  m_cache_rect = QRect();
+  m_cache_dirty = QRegion();
+  if(m_canvas && m_visible)
+    changed();
 }
 
 void KGameCanvasGroup::paint(QPainter* /*p*/) {
@@ -1005,11 +1221,7 @@ void KGameCanvasAdapter::ensurePendingUpdate()
 {
     m_child_rect_valid = false;
 
-    foreach (KGameCanvasItem* el, m_items) {
-        if (el->m_changed) {
-            el->updateChanges();
-        }
-    }
+    updateChangedItems();
 
     updateParent(m_invalidated_rect);
     m_invalidated_rect = QRect();
@@ -31,6 +31,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  Author: Maurizio Monge <maurizio.monge@gmail.com>
  */
 
+#include "frameclock.h"
 #include "kgamerendererclient.h"
 
 #include <QtCore/QList>
@@ -43,6 +44,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QtGui/QWidget>
 
 class KGameCanvasItem;
+class KGameCanvasIndex;
 
 /**
     \class KGameCanvasAbstract kgamecanvas.h <KGameCanvas>
@@ -59,6 +61,23 @@ protected:
 
     QList<KGameCanvasItem*> m_items;
     QList<KGameCanvasItem*> m_animated_items;
+    QList<KGameCanvasItem*> m_changed_items;
+
+    /* the visible items, by the cells of a uniform grid they cover */
+    KGameCanvasIndex* m_index;
+    /* set when the stacking order of the items has to be numbered again */
+    bool m_restacked;
+
+    /* update the items which changed since the last update */
+    void updateChangedItems();
+
+    /* paint the items intersecting the region, skipping those covered by
+       opaque items over them. The region is in the coordinates of the
+       toplevel canvas, and delta the position of this canvas in them */
+    void paintItems(QPainter* p, const QRect& prect, const QRegion& preg,
+                    const QPoint& delta, double cumulative_opacity);
+
+    static bool stackedUnder(const KGameCanvasItem* a, const KGameCanvasItem* b);
 
 public:
     /** The constructor */
@@ -66,6 +85,11 @@ public:
 
     virtual ~KGameCanvasAbstract();
 
+    /** Set the size of the cells of the index used to find the items in the
+        area to repaint. It works best when most items cover few cells, for
+        example when the cells are the tiles of a board. The default is 64 */
+    void setIndexCellSize(int size);
+
     /** Returns a const pointer to the list holding all the items in the canvas */
     const QList<KGameCanvasItem*>* items() const { return &m_items; }
 
@@ -121,7 +145,9 @@ private:
 
     bool m_visible;
     bool m_animated;
+    bool m_opaque;
     int  m_opacity;
+    int  m_stack;
     QPoint m_pos;
     KGameCanvasAbstract *m_canvas;
 
@@ -138,6 +164,9 @@ private:
     /* function to update pending changes, called from parent */
     virtual void updateChanges();
 
+    /* put the current rect of the item in the index of the parent */
+    void updateIndex();
+
 public:
     /** Constructor, it allows you to specify the reference canvas or to create
         an orphan item that will be put into a canvas in a second moment.
@@ -170,6 +199,13 @@ public:
     /** Set the item's opacity value (int the 0-255 range) */
     void setOpacity(int o);
 
+    /** Returns true if the item covers its whole rect when fully opaque */
+    bool opaque() const { return m_opaque; }
+
+    /** Tell the canvas that the item covers its whole rect with opaque pixels
+        when its opacity is 255, so that the items under it are not painted */
+    void setOpaque(bool o) { m_opaque = o; }
+
     /** Hides the item */
     void hide(){ setVisible(false); }
 
@@ -272,8 +308,15 @@ private:
     mutable bool m_child_rect_changed;
     mutable QRect m_last_child_rect;
 
+    bool m_cached;
+    QPixmap m_cache;
+    QRect m_cache_rect;
+    QRegion m_cache_dirty;
+
     virtual void paintInternal(QPainter* p, const QRect& prect, const QRegion& preg,
                                           const QPoint& delta, double cumulative_opacity);
+    void paintCached(QPainter* p, const QRect& prect, const QPoint& delta,
+                     double cumulative_opacity);
 
     virtual void ensureAnimating();
     virtual void ensurePendingUpdate();
@@ -297,6 +340,14 @@ public:
     /** Animations step, updates the animation for the children */
     virtual void advance(int msecs);
 
+    /** Returns true if the children are composited into a cached pixmap */
+    bool cached() const { return m_cached; }
+
+    /** Composite the children into a pixmap, and paint the group from it.
+        Only the parts of the pixmap where children changed are painted
+        again, so this suits groups of items which seldom change */
+    void setCached(bool c);
+
     /** returns the toplevel canvas (or null if it is in an orphan tree) */
     KGameCanvasWidget* topLevelCanvas();
 
@@ -570,7 +621,7 @@ public:
 
     \deprecated For new applications, use Qt's Graphics View framework or Qt Quick.
 */
-class  KGameCanvasWidget : public QWidget, public KGameCanvasAbstract
+class  KGameCanvasWidget : public QWidget, public KGameCanvasAbstract, private FrameClient
 {
 Q_OBJECT
 private:
@@ -586,8 +637,12 @@ private:
 
     virtual void paintEvent(QPaintEvent *event);
 
+    /** Animated items are advanced, and changes painted, on the frames
+        of the FrameClock shared with the Animator */
+    virtual bool advanceFrame(qint64 msecs);
+    virtual void paintFrame();
+
 private Q_SLOTS:
-    void processAnimations();
     void updateChanges();
 
 public:
@@ -596,7 +651,8 @@ public:
 
     virtual ~KGameCanvasWidget();
 
-    /** Set the delay of the animation, in milliseconds */
+    /** Set the delay of the animation, in milliseconds. The frame rate is
+        shared by every canvas and animation of the application. */
     void setAnimationDelay(int d);
 
     /** Return the number of millisecons from the creation of the canvas
@@ -23,7 +23,9 @@
 #include "kgamerendererclient.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDateTime>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QScopedPointer>
 #include <QtGui/QPainter>
@@ -156,10 +158,82 @@ void KGameRenderer::setTheme(const QString& theme)
 	}
 }
 
+//Themes are plain SVG files here, so the disk cache is named after the file.
+static QString themeCacheName(const QString& theme)
+{
+	return QString::fromLatin1("/.kgamerenderer-%1").arg(QFileInfo(theme).completeBaseName());
+}
+
+//The disk cache is stamped with a checksum of the SVG instead of its
+//modification time: themes compiled into the resources have none, and caches
+//prepared offline (see tools/prerender) come from another copy of the file.
+static bool themeChecksum(const QString& theme, uint* checksum)
+{
+	QFile file(theme);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	const QByteArray hash = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+	*checksum = (uint(uchar(hash[0])) << 24) | (uint(uchar(hash[1])) << 16) | (uint(uchar(hash[2])) << 8) | uint(uchar(hash[3]));
+	return true;
+}
+
 bool KGameRendererPrivate::setTheme(const QString& theme)
 {
-    Q_UNUSED(theme);
-    return true;
+	if (theme.isEmpty())
+	{
+		return false;
+	}
+	uint checksum;
+	if (!themeChecksum(theme, &checksum))
+	{
+		qDebug() << "Cannot read theme" << theme;
+		return false;
+	}
+	//open cache (and SVG file, if necessary)
+	if (m_strategies & KGameRenderer::UseDiskCache)
+	{
+		QScopedPointer<KImageCache> cache(new KImageCache(themeCacheName(theme), m_cacheSize));
+		cache->setPixmapCaching(false); //see big comment in KGRPrivate class declaration
+		//try to instantiate renderer immediately if the cache is new or outdated
+		if (cache->timestamp() != checksum)
+		{
+			qDebug() << "Theme differs from cache, checking SVG";
+			QSvgRenderer* renderer = new QSvgRenderer(theme);
+			if (!renderer->isValid())
+			{
+				delete renderer;
+				return false;
+			}
+			m_rendererPool.setPath(theme, renderer);
+			cache->clear();
+			cache->setTimestamp(checksum);
+		}
+		else
+		{
+			m_rendererPool.setPath(theme);
+		}
+		delete m_imageCache;
+		m_imageCache = cache.take();
+	}
+	else
+	{
+		QSvgRenderer* renderer = new QSvgRenderer(theme);
+		if (!renderer->isValid())
+		{
+			delete renderer;
+			return false;
+		}
+		m_rendererPool.setPath(theme, renderer);
+	}
+	//clear in-process caches
+	m_pixmapCache.clear();
+	m_frameCountCache.clear();
+	m_boundsCache.clear();
+	//done
+	m_currentTheme = theme;
+	return true;
 }
 
 QString KGameRendererPrivate::spriteFrameKey(const QString& key, int frame, bool normalizeFrameNo) const
@@ -207,7 +281,7 @@ int KGameRenderer::frameCount(const QString& key) const
 	int count = -1;
 	bool countFound = false;
 	const QString cacheKey = d->m_frameCountPrefix + key;
-	if (d->m_rendererPool.hasAvailableRenderers() && (d->m_strategies & KGameRenderer::UseDiskCache))
+	if (!d->m_rendererPool.hasAvailableRenderers() && (d->m_strategies & KGameRenderer::UseDiskCache))
 	{
 		QByteArray buffer;
 		if (d->m_imageCache->find(cacheKey, &buffer))
@@ -311,6 +385,67 @@ QPixmap KGameRenderer::spritePixmap(const QString& key, const QSize& size, int f
 	return result;
 }
 
+QString KGameRendererPrivate::cacheKey(const KGRInternal::ClientSpec& spec, const QString& elementKey) const
+{
+	QString cacheKey = m_sizePrefix.arg(spec.size.width()).arg(spec.size.height()) + elementKey;
+	QHash<QColor, QColor>::const_iterator it1 = spec.customColors.constBegin(), it2 = spec.customColors.constEnd();
+	static const QString colorSuffix(QLatin1String( "-%1-%2" ));
+	for (; it1 != it2; ++it1)
+	{
+		cacheKey += colorSuffix.arg(it1.key().rgba()).arg(it1.value().rgba());
+	}
+	return cacheKey;
+}
+
+bool KGameRenderer::prerenderSprite(const QString& key, const QSize& size, int frame)
+{
+	if (size.isEmpty() || !(d->m_strategies & KGameRenderer::UseDiskCache))
+	{
+		return false;
+	}
+	//ensure that some theme is loaded
+	if (d->m_currentTheme.isEmpty())
+	{
+		setTheme(d->m_defaultTheme);
+		if (d->m_currentTheme.isEmpty())
+		{
+			return false;
+		}
+	}
+	const KGRInternal::ClientSpec spec(key, frame, size);
+	const QString elementKey = d->spriteFrameKey(key, frame);
+	const QString cacheKey = d->cacheKey(spec, elementKey);
+	//nothing to do if already rendered or being rendered
+	if (d->m_pendingRequests.contains(cacheKey) || d->m_pixmapCache.contains(cacheKey)
+		|| d->m_imageCache->contains(cacheKey))
+	{
+		return false;
+	}
+	//like an asynchronous request that nobody waits for
+	KGRInternal::Job* job = new KGRInternal::Job;
+	job->rendererPool = &d->m_rendererPool;
+	job->cacheKey = cacheKey;
+	job->elementKey = elementKey;
+	job->spec = spec;
+	d->m_workerPool.start(new KGRInternal::Worker(job, false, d));
+	d->m_pendingRequests << cacheKey;
+	return true;
+}
+
+bool KGameRenderer::isRendering() const
+{
+	return !d->m_pendingRequests.isEmpty();
+}
+
+QString KGameRenderer::cacheFileName() const
+{
+	if (d->m_currentTheme.isEmpty() || !(d->m_strategies & KGameRenderer::UseDiskCache))
+	{
+		return QString();
+	}
+	return KSharedDataCache::cacheFileName(themeCacheName(d->m_currentTheme));
+}
+
 //Helper function for KGameRendererPrivate::requestPixmap.
 void KGameRendererPrivate::requestPixmap__propagateResult(const QPixmap& pixmap, KGameRendererClient* client, QPixmap* synchronousResult)
 {
@@ -334,13 +469,7 @@ void KGameRendererPrivate::requestPixmap(const KGRInternal::ClientSpec& spec, KG
 		return;
 	}
 	const QString elementKey = spriteFrameKey(spec.spriteKey, spec.frame);
-	QString cacheKey = m_sizePrefix.arg(spec.size.width()).arg(spec.size.height()) + elementKey;
-	QHash<QColor, QColor>::const_iterator it1 = spec.customColors.constBegin(), it2 = spec.customColors.constEnd();
-	static const QString colorSuffix(QLatin1String( "-%1-%2" ));
-	for (; it1 != it2; ++it1)
-	{
-		cacheKey += colorSuffix.arg(it1.key().rgba()).arg(it1.value().rgba());
-	}
+	const QString cacheKey = this->cacheKey(spec, elementKey);
 	//check if update is needed
 	if (client)
 	{
@@ -414,21 +543,25 @@ void KGameRendererPrivate::jobFinished(KGRInternal::Job* job, bool isSynchronous
 	m_pendingRequests.removeAll(cacheKey);
 	const QList<KGameRendererClient*> requesters = m_clients.keys(cacheKey);
 	//put result into image cache
-	if (m_strategies & KGameRenderer::UseDiskCache)
+	const bool useDiskCache = m_strategies & KGameRenderer::UseDiskCache;
+	if (useDiskCache)
 	{
 		m_imageCache->insertImage(cacheKey, result);
-		//convert result to pixmap (and put into pixmap cache) only if it is needed now
-		//This optimization saves the image-pixmap conversion for intermediate sizes which occur during smooth resize events or window initializations.
-		if (!isSynchronous && requesters.isEmpty())
+	}
+	//convert result to pixmap (and put into pixmap cache) only if it is needed now
+	//This optimization saves the image-pixmap conversion for intermediate sizes which occur during smooth resize events or window initializations, and for prerendered sprites.
+	if (isSynchronous || !requesters.isEmpty() || !useDiskCache)
+	{
+		const QPixmap pixmap = QPixmap::fromImage(result);
+		m_pixmapCache.insert(cacheKey, pixmap);
+		foreach (KGameRendererClient* requester, requesters)
 		{
-			return;
+			requester->receivePixmap(pixmap);
 		}
 	}
-	const QPixmap pixmap = QPixmap::fromImage(result);
-	m_pixmapCache.insert(cacheKey, pixmap);
-	foreach (KGameRendererClient* requester, requesters)
+	if (!isSynchronous && m_pendingRequests.isEmpty())
 	{
-		requester->receivePixmap(pixmap);
+		emit m_parent->renderingFinished();
 	}
 }
 
@@ -117,7 +117,7 @@ class KGameRenderer : public QObject
 		///@note If you load the theme name from a configuration file, give that
 		///theme name as the first argument instead of calling setTheme() later.
 		///setTheme() clears the cache, while this constructor tries to reuse it.
-		///@param defaultTheme a theme name as used by KGameTheme::load
+		///@param defaultTheme the path of the SVG file of a theme
 		///@param cacheSize the cache size in megabytes (if not given, a sane
 		///default is used)
 		///@warning This constructor may only be called from the main thread.
@@ -170,7 +170,7 @@ class KGameRenderer : public QObject
 		///If you disable UseDiskCache, you should do so before setTheme(),
 		///because changes to UseDiskCache cause a full theme reload.
 		void setStrategyEnabled(Strategy strategy, bool enabled = true);
-		///@return the theme currently in use (format as in KGameTheme::load())
+		///@return the path of the SVG file of the theme currently in use
 		QString theme() const;
 
 		///@return the bounding rectangle of the sprite with this @a key
@@ -207,16 +207,31 @@ class KGameRenderer : public QObject
 		// The parentheses around QHash<QColor, QColor>() avoid compile
 		// errors on platforms with older gcc versions, e.g. OS X 10.6.
 		QPixmap spritePixmap(const QString& key, const QSize& size, int frame = -1, const QHash<QColor, QColor>& customColors = (QHash<QColor, QColor>())) const;
+		///Renders the sprite with the given @a key at the given @a size into
+		///the disk cache in a worker thread, unless it is cached already, so
+		///that clients asking for it later on get it without waiting. Nothing
+		///is done unless the UseDiskCache strategy is enabled.
+		///@return whether a rendering job was started
+		///@see renderingFinished()
+		bool prerenderSprite(const QString& key, const QSize& size, int frame = -1);
+		///@return whether rendering jobs are running in worker threads
+		bool isRendering() const;
+		///@return the file holding the disk cache of the current theme, or an
+		///empty string if no theme is loaded or the disk cache is not used
+		QString cacheFileName() const;
 	public Q_SLOTS:
 		///Load the given theme and update the pixmaps of all associated
 		///KGameRendererClient instances.
-		///@param theme a theme name as used by KGameTheme::load
+		///@param theme the path of the SVG file of a theme
 		void setTheme(const QString& theme);
 	Q_SIGNALS:
 		///This signal is emitted when a new theme has been loaded. You usually
 		///do not need to react on this signal if you use KGameRendererClient or
 		///KGameRenderedItem, because these update their pixmaps automatically.
 		void themeChanged(const QString& theme);
+		///This signal is emitted when the last of the rendering jobs running
+		///in worker threads has finished, and its result is in the caches.
+		void renderingFinished();
 	private:
 		friend class KGameRendererPrivate;
 		friend class KGameRendererClient;
@@ -116,6 +116,7 @@ class KGameRendererPrivate : public QObject
 		KGameRendererPrivate(const QString& defaultTheme, unsigned cacheSize, KGameRenderer* parent);
 		bool setTheme(const QString& theme);
 		inline QString spriteFrameKey(const QString& key, int frame, bool normalizeFrameNo = false) const;
+		QString cacheKey(const KGRInternal::ClientSpec& spec, const QString& elementKey) const;
 		void requestPixmap(const KGRInternal::ClientSpec& spec, KGameRendererClient* client, QPixmap* synchronousResult = 0);
 	private:
 		inline void requestPixmap__propagateResult(const QPixmap& pixmap, KGameRendererClient* client, QPixmap* synchronousResult);
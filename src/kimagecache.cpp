@@ -25,8 +25,106 @@
 #include <QtGui/QImage>
 #include <QtGui/QPixmap>
 
+#include <string.h>
 #include <time.h>
 
+/**
+ * Images stored with RawStorage start with this header. The scanlines follow
+ * at dataOffset bytes from its start, exactly as QImage holds them.
+ */
+struct RawImageHeader
+{
+    quint32 magic;
+    qint32  width;
+    qint32  height;
+    qint32  bytesPerLine;
+    qint32  format;       ///< QImage::Format
+    quint32 dataOffset;
+};
+
+// Unlike the PNG signature, which begins with 0x89. Stored in host byte
+// order, so the bytes read "1RIK" on little-endian hosts.
+static const quint32 RAW_IMAGE_MAGIC = 0x4b495231; // 'KIR1'
+
+static QByteArray encodeRawImage(const QString &key, const QImage &image)
+{
+    QImage pixels = image;
+    if (pixels.format() != QImage::Format_ARGB32_Premultiplied &&
+        pixels.format() != QImage::Format_RGB32)
+    {
+        pixels = pixels.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    RawImageHeader header;
+    header.magic = RAW_IMAGE_MAGIC;
+    header.width = pixels.width();
+    header.height = pixels.height();
+    header.bytesPerLine = pixels.bytesPerLine();
+    header.format = pixels.format();
+
+    // KSharedDataCache stores the data right after the UTF-8 key and its
+    // null, which start a page. Pad so that the scanlines are 32-bit aligned
+    // in shared memory, and copyRawImage() copies them from aligned pixels.
+    uint start = key.toUtf8().size() + 1 + sizeof(header);
+    header.dataOffset = sizeof(header) + (4 - start % 4) % 4;
+
+    QByteArray data(header.dataOffset + pixels.byteCount(), '\0');
+    ::memcpy(data.data(), &header, sizeof(header));
+    ::memcpy(data.data() + header.dataOffset, pixels.constBits(), pixels.byteCount());
+
+    return data;
+}
+
+/**
+ * Reads the header of an image stored with RawStorage.
+ * @return false if @p data is not such an image (but a PNG for instance).
+ */
+static bool readRawImageHeader(const char *data, uint size, RawImageHeader *header)
+{
+    if (size < sizeof(*header)) {
+        return false;
+    }
+
+    ::memcpy(header, data, sizeof(*header));
+
+    if (header->magic != RAW_IMAGE_MAGIC ||
+        (header->format != QImage::Format_ARGB32_Premultiplied &&
+         header->format != QImage::Format_RGB32) ||
+        header->width <= 0 || header->height <= 0 ||
+        header->bytesPerLine < 4 * header->width ||
+        header->dataOffset > size)
+    {
+        return false;
+    }
+
+    return (size - header->dataOffset) / header->bytesPerLine >= uint(header->height);
+}
+
+/**
+ * @return the image stored with RawStorage in @p data, which is not
+ * referenced by the result.
+ */
+static QImage copyRawImage(const char *data, const RawImageHeader &header)
+{
+    QImage image(header.width, header.height, QImage::Format(header.format));
+    if (image.isNull()) {
+        return image;
+    }
+
+    const char *line = data + header.dataOffset;
+    if (image.bytesPerLine() == header.bytesPerLine) {
+        ::memcpy(image.bits(), line, image.byteCount());
+        return image;
+    }
+
+    int lineSize = qMin(image.bytesPerLine(), header.bytesPerLine);
+    for (int y = 0; y < header.height; ++y) {
+        ::memcpy(image.scanLine(y), line, lineSize);
+        line += header.bytesPerLine;
+    }
+
+    return image;
+}
 
 /**
  * This is a QObject subclass so we can catch the signal that the application is about
@@ -41,6 +139,7 @@ class KImageCache::Private : public QObject
         : QObject(parent)
         , timestamp(::time(0))
         , enablePixmapCaching(true)
+        , storageFormat(KImageCache::RawStorage)
     {
         QObject::connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
                          this, SLOT(clearPixmaps()));
@@ -78,6 +177,8 @@ class KImageCache::Private : public QObject
     QCache<QString, QPixmap> pixmapCache;
 
     bool enablePixmapCaching;
+
+    KImageCache::StorageFormat storageFormat;
 };
 
 
@@ -98,11 +199,17 @@ KImageCache::~KImageCache()
 
 bool KImageCache::insertImage(const QString &key, const QImage &image)
 {
-    QBuffer buffer;
-    buffer.open(QBuffer::WriteOnly);
-    image.save(&buffer, "PNG");
+    QByteArray data;
+    if (d->storageFormat == RawStorage) {
+        data = encodeRawImage(key, image);
+    }
+    else {
+        QBuffer buffer(&data);
+        buffer.open(QBuffer::WriteOnly);
+        image.save(&buffer, "PNG");
+    }
 
-    if (this->insert(key, buffer.buffer())) {
+    if (this->insert(key, data)) {
         d->timestamp = ::time(0);
         return true;
     }
@@ -123,13 +230,21 @@ bool KImageCache::insertPixmap(const QString &key, const QPixmap &pixmap)
 
 bool KImageCache::findImage(const QString &key, QImage *destination) const
 {
-    QByteArray cachedData;
-    if (!this->find(key, &cachedData) || cachedData.isNull()) {
+    // Decode straight out of shared memory instead of copying it first
+    Entry entry;
+    if (!this->findEntry(key, &entry)) {
         return false;
     }
 
     if (destination) {
-        destination->loadFromData(cachedData, "PNG");
+        RawImageHeader header;
+        if (readRawImageHeader(entry.constData(), entry.size(), &header)) {
+            *destination = copyRawImage(entry.constData(), header);
+        }
+        else {
+            destination->loadFromData(reinterpret_cast<const uchar *>(entry.constData()),
+                                      entry.size(), "PNG");
+        }
     }
 
     return true;
@@ -148,13 +263,23 @@ bool KImageCache::findPixmap(const QString &key, QPixmap *destination) const
         }
     }
 
-    QByteArray cachedData;
-    if (!this->find(key, &cachedData) || cachedData.isNull()) {
+    Entry entry;
+    if (!this->findEntry(key, &entry)) {
         return false;
     }
 
     if (destination) {
-        destination->loadFromData(cachedData, "PNG");
+        RawImageHeader header;
+        if (!readRawImageHeader(entry.constData(), entry.size(), &header)) {
+            destination->loadFromData(reinterpret_cast<const uchar *>(entry.constData()),
+                                      entry.size(), "PNG");
+        }
+        else {
+            // The raster backend shares the pixels of an image of the right
+            // format instead of copying them, so they must not stay in
+            // shared memory.
+            *destination = QPixmap::fromImage(copyRawImage(entry.constData(), header));
+        }
 
         // Manually re-insert to pixmap cache if we'll be using this one.
         d->insertPixmap(key, new QPixmap(*destination));
@@ -199,4 +324,14 @@ void KImageCache::setPixmapCacheLimit(int size)
     d->pixmapCache.setMaxCost(size);
 }
 
+KImageCache::StorageFormat KImageCache::storageFormat() const
+{
+    return d->storageFormat;
+}
+
+void KImageCache::setStorageFormat(StorageFormat format)
+{
+    d->storageFormat = format;
+}
+
 #include "kimagecache.moc"
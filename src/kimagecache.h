@@ -76,6 +76,24 @@ class KImageCache : public KSharedDataCache
                 unsigned defaultCacheSize,
                 unsigned expectedItemSize = 0);
 
+    /**
+     * How images are stored in the shared cache.
+     * @see setStorageFormat()
+     */
+    enum StorageFormat
+    {
+        /**
+         * Uncompressed premultiplied ARGB32 (or RGB32) scanlines behind a
+         * small header. Takes more room, but a hit is a copy instead of a
+         * decode. This is the default.
+         */
+        RawStorage,
+        /**
+         * PNG encoded images, small but slow to encode and decode.
+         */
+        PngStorage
+    };
+
     /**
      * Deconstructor
      */
@@ -160,6 +178,19 @@ class KImageCache : public KSharedDataCache
      */
     int pixmapCacheLimit() const;
 
+    /**
+     * @return The format new images are stored in.
+     */
+    StorageFormat storageFormat() const;
+
+    /**
+     * Sets the format images inserted from now on are stored in. Images are
+     * found whatever format they were stored in.
+     *
+     * @param format The new storage format.
+     */
+    void setStorageFormat(StorageFormat format);
+
     /**
      * Sets the highest memory size the pixmap cache should use.
      *
@@ -29,14 +29,17 @@
 #include <QtCore/QAtomicInt>
 #include <QtCore/QByteArray>
 #include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QList>
 #include <QtCore/QMutex>
 #include <QtCore/QMutexLocker>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QSharedPointer>
 
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <signal.h>
 #include <stdlib.h>
 
 #if defined(__GNUC__) && __GNUC__ - 0 >= 3
@@ -47,28 +50,6 @@
 # define KDE_ISUNLIKELY( x )  ( x )
 #endif
 
-
-int krandom()
-{
-    static bool init = false;
-    if (!init)
-    {
-        unsigned int seed;
-        init = true;
-        QFile fd("/dev/urandom");
-        if (!fd.open(QIODevice::ReadOnly) < 0 ||
-            fd.read((char *)&seed, sizeof(seed)) == -1)
-        {
-            // No /dev/urandom... try something else.
-            srand(getpid());
-            seed = rand()+time(0);
-        }
-        if (fd.isOpen()) fd.close();
-        srand(seed);
-    }
-    return rand();
-}
-
 //-----------------------------------------------------------------------------
 // MurmurHashAligned, by Austin Appleby
 // (Released to the public domain, or licensed under the MIT license where
@@ -276,7 +257,10 @@ typedef qint32 pageID;
 //
 // The page table contains shared memory split into fixed-size pages, with a
 // configurable page size. In the event that the data is too large to fit into
-// a single logical page, it will need to occupy consecutive pages of memory.
+// a single logical page, it will need to occupy several pages of memory. These
+// are consecutive whenever possible, but the pages of an entry form a chain so
+// that any free pages can be used when there is no run of them long enough.
+// Compaction moves used pages into free ones a few at a time, restoring runs.
 //
 // The accounting data that was referenced earlier is split into two:
 //
@@ -289,6 +273,20 @@ typedef qint32 pageID;
 // and it contains the index of the one entry in the index table actually
 // holding the page (or <0 if the page is free).
 //
+// An entry pinned by a KSharedDataCache::Entry is neither removed nor moved
+// until it is unpinned, since some process reads its pages in place. Only one
+// attachment of the cache pins an entry at a time, so that the pins of a
+// process which died holding them can be dropped. clear() cannot remove a
+// pinned entry, so it only makes it impossible to find, and the last unpin
+// removes it.
+//
+// Entries to evict are chosen with the CLOCK algorithm: a hand sweeps the
+// index table, giving a second chance to entries looked up since it last
+// passed (or, for least-often-used eviction, halving their use count) and
+// evicting the first one that has none left. Oldest-first eviction follows a
+// list of the entries by age instead. Either way a victim costs O(1)
+// amortized, instead of sorting the index table.
+//
 // The entire segment looks like so:
 // ?════════?═════════════?════════════?═══════?═══════?═══════?═══════?═══?
 // ? Header │ Index Table │ Page Table ? Pages │       │       │       │...?
@@ -299,14 +297,70 @@ typedef qint32 pageID;
 // will be in shared memory.  In addition, no pointers!  To point to something
 // you must use relative offsets since the pointer start addresses will be
 // different in each process.
+//
+// Lookups only hold the lock for reading, so the fields they update are
+// atomic. lastUsedTime holds a time_t cut to 32 bits, see lastUsed().
 struct IndexTableEntry
 {
-            uint   fileNameHash;
-            uint   totalItemSize; // in bytes
-    mutable uint   useCount;
-            time_t addTime;
-    mutable time_t lastUsedTime;
-            pageID firstPage;
+            uint       fileNameHash;
+            uint       totalItemSize; // in bytes
+    mutable QAtomicInt useCount;
+            time_t     addTime;
+    mutable QAtomicInt lastUsedTime;
+            pageID     firstPage;
+    mutable QAtomicInt pinCount; // KSharedDataCache::Entry objects referring to it
+    mutable QAtomicInt pinOwner; // attachment the pins belong to, 0 if none
+    mutable QAtomicInt pinPid;   // process of that attachment
+            bool       removed;  // by clear() while pinned
+    mutable QAtomicInt referenced; // looked up since the clock hand last passed
+            qint32     olderEntry; // neighbours in the list of entries by age,
+            qint32     newerEntry; // <0 at its ends
+
+    uint lastUsed() const
+    {
+        return static_cast<uint>(static_cast<int>(lastUsedTime));
+    }
+
+    // Records a lookup, which may race with others.
+    void touch() const
+    {
+        useCount.ref();
+        lastUsedTime.fetchAndStoreRelaxed(static_cast<int>(::time(0)));
+        if (!referenced) {
+            referenced.fetchAndStoreRelaxed(1);
+        }
+    }
+};
+
+// A 64-bit counter of two atomic halves, for statistics updated under the
+// shared lock. A reader may see it in the middle of a carry, but no count
+// is ever lost.
+struct SharedCounter
+{
+    QAtomicInt low;
+    QAtomicInt high;
+
+    void add(quint64 n)
+    {
+        uint lowPart = static_cast<uint>(n);
+        uint before = static_cast<uint>(low.fetchAndAddRelaxed(static_cast<int>(lowPart)));
+        uint highPart = static_cast<uint>(n >> 32) + (before + lowPart < before ? 1 : 0);
+        if (highPart != 0) {
+            high.fetchAndAddRelaxed(static_cast<int>(highPart));
+        }
+    }
+
+    quint64 value() const
+    {
+        return (static_cast<quint64>(static_cast<uint>(static_cast<int>(high))) << 32) |
+                static_cast<uint>(static_cast<int>(low));
+    }
+
+    void reset()
+    {
+        low = 0;
+        high = 0;
+    }
 };
 
 // Page table entry
@@ -314,12 +368,15 @@ struct PageTableEntry
 {
     // int so we can use values <0 for unassigned pages.
     qint32 index;
+
+    // The page holding the rest of the entry, <0 for the last one.
+    pageID next;
 };
 
 // Each individual page contains the cached data. The first page starts off with
 // the utf8-encoded key, a null '\0', and then the data follows immediately
-// from the next byte, possibly crossing consecutive page boundaries to hold
-// all of the data.
+// from the next byte, possibly crossing page boundaries (following the chain
+// in the page table) to hold all of the data.
 // There is, however, no specific struct for a page, it is simply a location in
 // memory.
 
@@ -336,8 +393,11 @@ struct SharedMemory
      * e.g. the next version bump will be from 4 to 8, then 12, etc.
      */
     enum {
-        PIXMAP_CACHE_VERSION = 12,
-        MINIMUM_CACHE_SIZE = 4096
+        PIXMAP_CACHE_VERSION = 36,
+        MINIMUM_CACHE_SIZE = 4096,
+
+        // Positions of the index table a key may be stored at
+        MAX_PROBES = 6
     };
 
     // Note to those who follow me. You should not, under any circumstances, ever
@@ -363,6 +423,32 @@ struct SharedMemory
     // written to, to allow clients to detect a changed cache quickly.
     QAtomicInt cacheTimestamp;
 
+    // Bumped by every attachment of a process to the cache, which tags the
+    // entries it pins with it.
+    QAtomicInt attachments;
+
+    // Pages before this one are all used (or were when compaction last
+    // looked at them).
+    pageID compactCursor;
+
+    // The next entry the CLOCK hand looks at, and the ends of the list of
+    // entries by age.
+    qint32 clockHand;
+    qint32 oldestEntry;
+    qint32 newestEntry;
+
+    // See KSharedDataCache::Statistics. These start at 0 with the rest of the
+    // segment, and survive clear().
+    SharedCounter hits;
+    SharedCounter misses;
+    SharedCounter inserts;
+    SharedCounter evictions;
+    SharedCounter collisions;
+    SharedCounter compactions;
+    SharedCounter pagesMoved;
+    SharedCounter lockCount;
+    SharedCounter lockTime;
+
     /**
      * Converts the given average item size into an appropriate page size.
      */
@@ -459,7 +545,9 @@ struct SharedMemory
         PageTableEntry *table = pageTable();
         for (uint i = 0; i < pageTableSize(); ++i) {
             table[i].index = -1;
+            table[i].next = -1;
         }
+        compactCursor = 0;
 
         // Setup index tables to be accurate.
         IndexTableEntry *indices = indexTable();
@@ -470,7 +558,17 @@ struct SharedMemory
             indices[i].totalItemSize = 0;
             indices[i].addTime = 0;
             indices[i].lastUsedTime = 0;
+            indices[i].pinCount = 0;
+            indices[i].pinOwner = 0;
+            indices[i].pinPid = 0;
+            indices[i].removed = false;
+            indices[i].referenced = 0;
+            indices[i].olderEntry = -1;
+            indices[i].newerEntry = -1;
         }
+        clockHand = 0;
+        oldestEntry = -1;
+        newestEntry = -1;
     }
 
     const IndexTableEntry *indexTable() const
@@ -581,122 +679,377 @@ struct SharedMemory
         return pageTableSize();
     }
 
-    // left < right?
-    static bool lruCompare(const IndexTableEntry &l, const IndexTableEntry &r)
+    /**
+     * @return the position of the index table to look at for the @p probe
+     * th time for a key hashed to @p keyHash. Collisions are handled with
+     * quadratic probing: position = (hash + (i + i*i) / 2) % size.
+     */
+    uint probePosition(uint keyHash, int probe) const
+    {
+        return (keyHash + (probe + probe * probe) / 2) % indexTableSize();
+    }
+
+    // left is a better victim than right?
+    bool colder(const IndexTableEntry &l, const IndexTableEntry &r) const
+    {
+        switch((int) evictionPolicy) {
+        case (int) KSharedDataCache::EvictLeastRecentlyUsed:
+            if (static_cast<int>(l.referenced) != static_cast<int>(r.referenced)) {
+                return !l.referenced;
+            }
+            return l.lastUsed() < r.lastUsed();
+
+        case (int) KSharedDataCache::EvictOldest:
+            return l.addTime < r.addTime;
+
+        case (int) KSharedDataCache::EvictLeastOftenUsed:
+        case (int) KSharedDataCache::NoEvictionPreference:
+        default:
+            return l.useCount < r.useCount;
+        }
+    }
+
+    /**
+     * @return Whether @p entry is pinned. The pins of a process which is
+     * gone are dropped, so the lock must be held for writing.
+     */
+    bool isPinned(const IndexTableEntry &entry) const
     {
-        // Ensure invalid entries migrate to the end
-        if (l.firstPage < 0 && r.firstPage >= 0) {
+        if (entry.pinCount == 0) {
             return false;
         }
-        if (l.firstPage >= 0 && r.firstPage < 0) {
+
+        if (::kill(entry.pinPid, 0) == 0 || errno != ESRCH) {
             return true;
         }
 
-        // Most recently used will have the highest absolute time =>
-        // least recently used (lowest) should go first => use left < right
-        return l.lastUsedTime < r.lastUsedTime;
+        qDebug() << "Dropping the pins of process" << static_cast<int>(entry.pinPid)
+                 << "which is gone.";
+        entry.pinCount = 0;
+        entry.pinOwner = 0;
+        return false;
     }
 
-    // left < right?
-    static bool seldomUsedCompare(const IndexTableEntry &l, const IndexTableEntry &r)
+    /**
+     * Finds where to insert an entry for a key hashed to @p keyHash: a free
+     * position where the key may be stored, or failing that the coldest
+     * entry in one, which has to be removed first. Pinned entries are never
+     * chosen.
+     *
+     * @return The position in the index table, <0 if they are all pinned.
+     */
+    qint32 insertPosition(uint keyHash) const
     {
-        // Ensure invalid entries migrate to the end
-        if (l.firstPage < 0 && r.firstPage >= 0) {
-            return false;
-        }
-        if (l.firstPage >= 0 && r.firstPage < 0) {
-            return true;
+        const IndexTableEntry *indices = indexTable();
+        qint32 victim = -1;
+
+        for (int probe = 0; probe < MAX_PROBES; ++probe) {
+            uint position = probePosition(keyHash, probe);
+            if (indices[position].firstPage < 0) {
+                return position;
+            }
+
+            if (!isPinned(indices[position]) &&
+                (victim < 0 || colder(indices[position], indices[victim])))
+            {
+                victim = position;
+            }
         }
 
-        // Put lowest use count at start by using left < right
-        return l.useCount < r.useCount;
+        return victim;
     }
 
-    // left < right?
-    static bool ageCompare(const IndexTableEntry &l, const IndexTableEntry &r)
+    /**
+     * Chooses the next entry to evict according to the eviction policy,
+     * moving the clock hand along. Pinned entries are never chosen.
+     *
+     * @return The index of the entry, <0 if every entry is pinned.
+     */
+    qint32 nextVictim()
     {
-        // Ensure invalid entries migrate to the end
-        if (l.firstPage < 0 && r.firstPage >= 0) {
-            return false;
+        IndexTableEntry *indices = indexTable();
+
+        if ((int) evictionPolicy == (int) KSharedDataCache::EvictOldest) {
+            for (qint32 i = oldestEntry; i >= 0; i = indices[i].newerEntry) {
+                if (!isPinned(indices[i])) {
+                    return i;
+                }
+            }
+            return -1;
         }
-        if (l.firstPage >= 0 && r.firstPage < 0) {
-            return true;
+
+        bool leastOftenUsed = (int) evictionPolicy != (int) KSharedDataCache::EvictLeastRecentlyUsed;
+        uint size = indexTableSize();
+
+        // Every visit of the hand takes some credit away from an entry, so
+        // this only runs out when everything is pinned (use counts are
+        // halved at most 31 times).
+        for (uint steps = 0; steps < 33 * size; ++steps) {
+            qint32 i = clockHand;
+            clockHand = (clockHand + 1) % size;
+
+            IndexTableEntry &entry = indices[i];
+            if (entry.firstPage < 0 || isPinned(entry)) {
+                continue;
+            }
+
+            if (leastOftenUsed) {
+                if (entry.useCount > 1) {
+                    entry.useCount = entry.useCount >> 1;
+                    continue;
+                }
+            }
+            else if (entry.referenced) {
+                entry.referenced = 0;
+                continue;
+            }
+
+            return i;
         }
 
-        // Oldest entries die first -- they have the lowest absolute add time,
-        // so just like the others use left < right
-        return l.addTime < r.addTime;
+        return -1;
     }
 
-    void defragment()
+    /**
+     * Adds the entry @p index as the newest one in the list by age.
+     */
+    void linkNewest(qint32 index)
     {
-        if (cacheAvail * cachePageSize() == cacheSize) {
-            return; // That was easy
+        IndexTableEntry *indices = indexTable();
+        indices[index].olderEntry = newestEntry;
+        indices[index].newerEntry = -1;
+
+        if (newestEntry >= 0) {
+            indices[newestEntry].newerEntry = index;
+        }
+        else {
+            oldestEntry = index;
+        }
+        newestEntry = index;
+    }
+
+    /**
+     * Removes the entry @p index from the list by age.
+     */
+    void unlink(qint32 index)
+    {
+        IndexTableEntry *indices = indexTable();
+        qint32 older = indices[index].olderEntry;
+        qint32 newer = indices[index].newerEntry;
+
+        if (older >= 0) {
+            indices[older].newerEntry = newer;
+        }
+        else {
+            oldestEntry = newer;
+        }
+
+        if (newer >= 0) {
+            indices[newer].olderEntry = older;
+        }
+        else {
+            newestEntry = older;
         }
 
-        qDebug() << "Defragmenting the shared cache";
+        indices[index].olderEntry = -1;
+        indices[index].newerEntry = -1;
+    }
 
-        // Just do a linear scan, and anytime there is free space, swap it
-        // with the pages to its right. In order to meet the precondition
-        // we need to skip any used pages first.
+    /**
+     * Takes @p pagesNeeded free pages for the entry @p index, consecutive ones
+     * if possible, and chains them.
+     * @return the first page, or pageTableSize() if there are not enough free
+     * pages.
+     */
+    pageID allocatePages(uint pagesNeeded, qint32 index)
+    {
+        if (pagesNeeded == 0 || pagesNeeded > cacheAvail) {
+            return pageTableSize();
+        }
 
-        pageID currentPage = 0;
-        pageID idLimit = static_cast<pageID>(pageTableSize());
         PageTableEntry *pages = pageTable();
+        pageID first = findEmptyPages(pagesNeeded);
 
-        // Skip used pages
-        while (currentPage < idLimit && pages[currentPage].index >= 0) {
-            ++currentPage;
+        if (first < static_cast<pageID>(pageTableSize())) {
+            for (uint i = 0; i < pagesNeeded; ++i) {
+                pages[first + i].index = index;
+                pages[first + i].next = i + 1 < pagesNeeded ? first + i + 1 : -1;
+            }
         }
+        else {
+            // Too fragmented, so gather free pages wherever they are.
+            first = -1;
+            pageID previous = -1;
+            uint found = 0;
+            for (pageID i = compactCursor; found < pagesNeeded &&
+                 i < static_cast<pageID>(pageTableSize()); ++i)
+            {
+                if (pages[i].index >= 0) {
+                    continue;
+                }
 
-        pageID freeSpot = currentPage;
+                pages[i].index = index;
+                pages[i].next = -1;
+                if (previous < 0) {
+                    first = i;
+                }
+                else {
+                    pages[previous].next = i;
+                }
+                previous = i;
+                ++found;
+            }
 
-        // Main loop, starting from a free page, skip to the used pages and
-        // move them back.
-        while (currentPage < idLimit) {
-            // Find the next used page
-            while (currentPage < idLimit && pages[currentPage].index < 0) {
-                ++currentPage;
+            if (found < pagesNeeded) {
+                qCritical() << "The cache claimed" << cacheAvail << "free pages,"
+                            << "but only" << found << "were found.";
+                clearInternalTables();
+                return pageTableSize();
             }
+        }
 
-            if (currentPage >= idLimit) {
-                break;
+        cacheAvail -= pagesNeeded;
+        return first;
+    }
+
+    /**
+     * @return true if the pages of the entry @p index are consecutive.
+     */
+    bool isContiguous(qint32 index) const
+    {
+        const PageTableEntry *pages = pageTable();
+        for (pageID i = indexTable()[index].firstPage; pages[i].next >= 0; ++i) {
+            if (pages[i].next != i + 1) {
+                return false;
             }
+        }
 
-            // Found an entry, move it.
-            qint32 affectedIndex = pages[currentPage].index;
-            Q_ASSERT(affectedIndex >= 0);
-            Q_ASSERT(indexTable()[affectedIndex].firstPage == currentPage);
+        return true;
+    }
 
-            indexTable()[affectedIndex].firstPage = freeSpot;
+    /**
+     * Copies @p size bytes of the entry @p index, from @p offset bytes into
+     * its first page on, to @p destination.
+     */
+    void readEntry(qint32 index, uint offset, char *destination, uint size) const
+    {
+        const PageTableEntry *pages = pageTable();
+        pageID current = indexTable()[index].firstPage;
 
-            // Moving one page at a time guarantees we can use memcpy safely
-            // (in other words, the source and destination will not overlap).
-            while (currentPage < idLimit && pages[currentPage].index >= 0) {
-                ::memcpy(page(freeSpot), page(currentPage), cachePageSize());
-                pages[freeSpot].index = affectedIndex;
-                pages[currentPage].index = -1;
-                ++currentPage;
-                ++freeSpot;
+        while (offset >= cachePageSize()) {
+            current = pages[current].next;
+            offset -= cachePageSize();
+        }
 
-                // If we've just moved the very last page and it happened to
-                // be at the very end of the cache then we're done.
-                if (currentPage >= idLimit) {
-                    break;
-                }
+        while (size > 0 && current >= 0) {
+            uint chunk = qMin(size, cachePageSize() - offset);
+            ::memcpy(destination, reinterpret_cast<const char *>(page(current)) + offset, chunk);
+            destination += chunk;
+            size -= chunk;
+            offset = 0;
+            current = pages[current].next;
+        }
+    }
+
+    /**
+     * Copies @p size bytes from @p source into the pages chained from
+     * @p firstPage, starting @p offset bytes into the first one.
+     */
+    void writeEntry(pageID firstPage, uint offset, const char *source, uint size)
+    {
+        const PageTableEntry *pages = pageTable();
+        pageID current = firstPage;
+
+        while (offset >= cachePageSize()) {
+            current = pages[current].next;
+            offset -= cachePageSize();
+        }
+
+        while (size > 0 && current >= 0) {
+            uint chunk = qMin(size, cachePageSize() - offset);
+            ::memcpy(reinterpret_cast<char *>(page(current)) + offset, source, chunk);
+            source += chunk;
+            size -= chunk;
+            offset = 0;
+            current = pages[current].next;
+        }
+    }
+
+    /**
+     * Moves the used page @p from into the free page @p to, keeping the chain
+     * of its entry in order.
+     */
+    void movePage(pageID from, pageID to)
+    {
+        PageTableEntry *pages = pageTable();
+        qint32 index = pages[from].index;
+        IndexTableEntry &entry = indexTable()[index];
+
+        Q_ASSERT(index >= 0 && pages[to].index < 0);
+
+        if (entry.firstPage == from) {
+            entry.firstPage = to;
+        }
+        else if (to > 0 && pages[to - 1].index == index && pages[to - 1].next == from) {
+            // The usual case: the previous page of the entry was just moved.
+            pages[to - 1].next = to;
+        }
+        else {
+            pageID previous = entry.firstPage;
+            while (pages[previous].next != from) {
+                previous = pages[previous].next;
+                Q_ASSERT(previous >= 0);
+            }
+            pages[previous].next = to;
+        }
+
+        ::memcpy(page(to), page(from), cachePageSize());
+        pages[to] = pages[from];
+        pages[from].index = -1;
+        pages[from].next = -1;
+    }
 
-                // We're moving consecutive used pages whether they belong to
-                // our affected entry or not, so detect if we've started moving
-                // the data for a different entry and adjust if necessary.
-                if (affectedIndex != pages[currentPage].index) {
-                    indexTable()[pages[currentPage].index].firstPage = freeSpot;
+    /**
+     * Compacts the cache a little: moves at most @p budget used pages down
+     * into the free pages before them, so that free pages end up together at
+     * the end of the cache, and entries in consecutive pages again. Pages of
+     * pinned entries stay where they are.
+     *
+     * @return true if the cache is compact, false if there is more to do.
+     */
+    bool compact(uint budget)
+    {
+        const PageTableEntry *pages = pageTable();
+        pageID limit = static_cast<pageID>(pageTableSize());
+        pageID freeSpot = compactCursor;
+        pageID used = freeSpot;
+        uint moved = 0;
+
+        while (true) {
+            // Find the first free page...
+            while (freeSpot < limit && pages[freeSpot].index >= 0) {
+                ++freeSpot;
+            }
+            compactCursor = freeSpot;
+
+            // ...and the next page after it that may move.
+            used = qMax(used, freeSpot + 1);
+            while (used < limit && (pages[used].index < 0 ||
+                   isPinned(indexTable()[pages[used].index])))
+            {
+                ++used;
+            }
+
+            if (used >= limit || moved == budget) {
+                if (moved > 0) {
+                    compactions.add(1);
+                    pagesMoved.add(moved);
                 }
-                affectedIndex = pages[currentPage].index;
+                return used >= limit;
             }
 
-            // At this point currentPage is on a page that is unused, and the
-            // cycle repeats. However, currentPage is not the first unused
-            // page, freeSpot is, so leave it alone.
+            movePage(used, freeSpot);
+            ++moved;
         }
     }
 
@@ -709,26 +1062,23 @@ struct SharedMemory
     qint32 findNamedEntry(const QByteArray &key) const
     {
         uint keyHash = generateHash(key);
-        uint position = keyHash % indexTableSize();
-        int probeNumber = 1; // See insert() for description
 
-        while (indexTable()[position].fileNameHash != keyHash &&
-              indexTable()[position].useCount > 0 &&
-              probeNumber < 6)
-        {
-            position = (keyHash + (probeNumber + probeNumber * probeNumber) / 2)
-                       % indexTableSize();
-            probeNumber++;
-        }
+        // Removals leave holes in probe sequences, so look at every position
+        // the key may be at.
+        for (int probe = 0; probe < MAX_PROBES; ++probe) {
+            uint position = probePosition(keyHash, probe);
+            const IndexTableEntry &entry = indexTable()[position];
+
+            if (entry.fileNameHash != keyHash || entry.removed) {
+                continue;
+            }
 
-        if (indexTable()[position].fileNameHash == keyHash) {
-            pageID firstPage = indexTable()[position].firstPage;
+            pageID firstPage = entry.firstPage;
             if (firstPage < 0 || static_cast<uint>(firstPage) >= pageTableSize()) {
-                return -1;
+                continue;
             }
-            const void *resultPage = page(firstPage);
-            const char *utf8FileName = reinterpret_cast<const char *>(resultPage);
 
+            const char *utf8FileName = reinterpret_cast<const char *>(page(firstPage));
             if (qstrncmp(utf8FileName, key.constData(), cachePageSize()) == 0) {
                 return position;
             }
@@ -737,151 +1087,51 @@ struct SharedMemory
         return -1; // Not found, or a different one found.
     }
 
-    // Function to use with QSharedPointer in removeUsedPages below...
-    static void deleteTable(IndexTableEntry *table) {
-        delete [] table;
-    }
-
     /**
-     * Removes the requested number of pages.
+     * Removes entries until at least the requested number of pages are free,
+     * consecutive or not.
      *
      * @param numberNeeded the number of pages required to fulfill a current request.
-     *        This number should be <0 and <= the number of pages in the cache.
-     * @return The identifier of the beginning of a consecutive block of pages able
-     *         to fill the request. Returns a value >= pageTableSize() if no such
-     *         request can be filled.
+     *        This number should be >0 and <= the number of pages in the cache.
+     * @return true if enough pages are free.
      * @internal
      */
-    uint removeUsedPages(uint numberNeeded)
+    bool removeUsedPages(uint numberNeeded)
     {
         if (numberNeeded == 0) {
             qCritical() << "Internal error: Asked to remove exactly 0 pages for some reason.";
-            return pageTableSize();
+            return false;
         }
 
         if (numberNeeded > pageTableSize()) {
             qCritical() << "Internal error: Requested more space than exists in the cache.";
             qCritical() << numberNeeded << "requested, " << pageTableSize() << "is the total possible.";
-            return pageTableSize();
-        }
-
-        // If the cache free space is large enough we will defragment first
-        // instead since it's likely we're highly fragmented.
-        // Otherwise, we will (eventually) simply remove entries per the
-        // eviction order set for the cache until there is enough room
-        // available to hold the number of pages we need.
-
-        qDebug() << "Removing old entries to free up" << numberNeeded << "pages,"
-                    << cacheAvail << "are already theoretically available.";
-
-        if (cacheAvail > 3 * numberNeeded) {
-            defragment();
-            uint result = findEmptyPages(numberNeeded);
-
-            if (result < pageTableSize()) {
-                return result;
-            }
-            else {
-                qCritical() << "Just defragmented a locked cache, but still there"
-                            << "isn't enough room for the current request.";
-            }
-        }
-
-        // At this point we know we'll have to free some space up, so sort our
-        // list of entries by whatever the current criteria are and start
-        // killing expired entries.
-        QSharedPointer<IndexTableEntry> tablePtr(new IndexTableEntry[indexTableSize()], deleteTable);
-
-        if (!tablePtr) {
-            qCritical() << "Unable to allocate temporary memory for sorting the cache!";
-            clearInternalTables();
-            return pageTableSize();
+            return false;
         }
 
-        // We use tablePtr to ensure the data is destroyed, but do the access
-        // via a helper pointer to allow for array ops.
-        IndexTableEntry *table = tablePtr.data();
-
-        ::memcpy(table, indexTable(), sizeof(IndexTableEntry) * indexTableSize());
-
-        // Our entry ID is simply its index into the
-        // index table, which qSort will rearrange all willy-nilly, so first
-        // we'll save the *real* entry ID into firstPage (which is useless in
-        // our copy of the index table). On the other hand if the entry is not
-        // used then we note that with -1.
-        for (uint i = 0; i < indexTableSize(); ++i) {
-            table[i].firstPage = table[i].useCount > 0 ? static_cast<pageID>(i)
-                                                       : -1;
+        if (numberNeeded <= cacheAvail) {
+            return true;
         }
 
-        // Declare the comparison function that we'll use to pass to qSort,
-        // based on our cache eviction policy.
-        bool (*compareFunction)(const IndexTableEntry &, const IndexTableEntry &);
-        switch((int) evictionPolicy) {
-        case (int) KSharedDataCache::EvictLeastOftenUsed:
-        case (int) KSharedDataCache::NoEvictionPreference:
-        default:
-            compareFunction = seldomUsedCompare;
-        break;
+        qDebug() << "Removing old entries to free up" << numberNeeded << "pages,"
+                    << cacheAvail << "are already available.";
 
-        case (int) KSharedDataCache::EvictLeastRecentlyUsed:
-            compareFunction = lruCompare;
-        break;
+        while (numberNeeded > cacheAvail) {
+            qint32 victim = nextVictim();
 
-        case (int) KSharedDataCache::EvictOldest:
-            compareFunction = ageCompare;
-        break;
-        }
-
-        qSort(table, table + indexTableSize(), compareFunction);
-
-        // Least recently used entries will be in the front.
-        // Start killing until we have room.
-
-        // Note on removeEntry: It expects an index into the index table,
-        // but our sorted list is all jumbled. But we stored the real index
-        // in the firstPage member.
-        // Remove entries until we've removed at least the required number
-        // of pages.
-        uint i = 0;
-        while (i < indexTableSize() && numberNeeded > cacheAvail) {
-            int curIndex = table[i++].firstPage; // Really an index, not a page
-
-            // Removed everything, still no luck. At *this* point,
-            // pagesRemoved < numberNeeded or in other words we can't fulfill
-            // the request even if we defragment. This is really a logic error.
-            if (curIndex < 0) {
-                qCritical() << "Unable to remove enough used pages to allocate"
-                              << numberNeeded << "pages. In theory the cache is empty, weird.";
-                return pageTableSize();
+            if (victim < 0) {
+                qDebug() << "Unable to remove enough used pages to allocate"
+                         << numberNeeded << "pages, the rest is pinned.";
+                return false;
             }
 
-            qDebug() << "Removing entry of" << indexTable()[curIndex].totalItemSize
+            qDebug() << "Removing entry of" << indexTable()[victim].totalItemSize
                         << "size";
-            removeEntry(curIndex);
+            removeEntry(victim);
+            evictions.add(1);
         }
 
-        // At this point let's see if we have freed up enough data by
-        // defragmenting first and seeing if we can find that free space.
-        defragment();
-
-        pageID result = pageTableSize();
-        while (i < indexTableSize() &&
-              (result = findEmptyPages(numberNeeded)) >= static_cast<int>(pageTableSize()))
-        {
-            int curIndex = table[i++].firstPage;
-
-            if (curIndex < 0) {
-                // One last shot.
-                defragment();
-                return findEmptyPages(numberNeeded);
-            }
-
-            removeEntry(curIndex);
-        }
-
-        // Whew.
-        return result;
+        return true;
     }
 
     // Returns the total size required for a given cache size.
@@ -921,7 +1171,33 @@ struct SharedMemory
 
     void clear()
     {
-        clearInternalTables();
+        IndexTableEntry *indices = indexTable();
+        bool pinned = false;
+        for (uint i = 0; i < indexTableSize() && !pinned; ++i) {
+            pinned = indices[i].firstPage >= 0 && isPinned(indices[i]);
+        }
+
+        if (!pinned) {
+            clearInternalTables();
+            return;
+        }
+
+        // Pinned entries are still being read, so their pages have to
+        // survive until the last unpin, but they are gone for lookups.
+        for (uint i = 0; i < indexTableSize(); ++i) {
+            if (indices[i].firstPage < 0) {
+                continue;
+            }
+
+            if (isPinned(indices[i])) {
+                indices[i].fileNameHash = 0;
+                indices[i].removed = true;
+                *reinterpret_cast<char *>(page(indices[i].firstPage)) = '\0';
+            }
+            else {
+                removeEntry(i);
+            }
+        }
     }
 
     void removeEntry(uint index);
@@ -940,6 +1216,8 @@ class KSharedDataCache::Private
         , shm(0)
         , m_lock(0)
         , m_mapSize(0)
+        , m_attachment(0)
+        , m_generation(0)
         , m_defaultCacheSize(defaultCacheSize)
         , m_expectedItemSize(expectedItemSize)
         , m_expectedType(static_cast<SharedLockId>(0))
@@ -957,13 +1235,140 @@ class KSharedDataCache::Private
         // cleared before shm is removed.
         m_lock.clear();
 
-        if (shm && !::munmap(shm, m_mapSize)) {
-            qCritical() << "Unable to unmap shared memory segment"
-                << static_cast<void*>(shm);
+        if (shm) {
+            unmap(shm, m_mapSize);
         }
 
         shm = 0;
         m_mapSize = 0;
+        m_attachment = 0;
+        ++m_generation;
+    }
+
+    // Removes a mapping of the cache, unless pinned entries of this process
+    // may still point into it: those mappings are removed by the last unpin().
+    void unmap(void *address, uint size)
+    {
+        QMutexLocker locker(&m_retiredLock);
+        if (m_pins > 0) {
+            m_retired.append(qMakePair(address, size));
+            return;
+        }
+
+        if (::munmap(address, size) != 0) {
+            qCritical() << "Unable to unmap shared memory segment" << address;
+        }
+    }
+
+    // Maps the cache again when another process enlarged it. Must be called
+    // with m_mapLock held for writing, and the cache lock released.
+    void remap()
+    {
+        if (!shm) {
+            return;
+        }
+
+        // Another thread may have done it already.
+        uint size = SharedMemory::totalSize(shm->cacheSize, shm->cachePageSize());
+        if (size <= m_mapSize) {
+            return;
+        }
+
+#ifdef KSDC_MSYNC_SUPPORTED
+        ::msync(shm, m_mapSize, MS_INVALIDATE | MS_ASYNC);
+#endif
+        unmap(shm, m_mapSize);
+        m_mapSize = 0;
+        shm = 0;
+
+        QFile f(m_cacheName);
+        if (!f.open(QFile::ReadWrite)) {
+            qCritical() << "Unable to re-open cache, unfortunately"
+                        << "the connection had to be dropped for"
+                        << "crash safety -- things will be much"
+                        << "slower now.";
+            return;
+        }
+
+        void *newMap = ::mmap(0, size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, f.handle(), 0);
+        if (newMap == MAP_FAILED) {
+            qCritical() << "Unopen to re-map the cache into memory"
+                        << "things will be much slower now";
+            return;
+        }
+
+        shm = reinterpret_cast<SharedMemory *>(newMap);
+        m_mapSize = size;
+
+        // The lock refers to the old mapping.
+        m_lock = QSharedPointer<KSDCLock>(createLockFromId(m_expectedType, shm->shmLock));
+    }
+
+    void unmapRetired()
+    {
+        QMutexLocker locker(&m_retiredLock);
+        if (m_pins > 0) {
+            return;
+        }
+
+        for (int i = 0; i < m_retired.size(); ++i) {
+            ::munmap(m_retired[i].first, m_retired[i].second);
+        }
+        m_retired.clear();
+    }
+
+    // Pins @p entry for this attachment, unless another one has it pinned.
+    // Must be called with the lock held.
+    bool pin(const IndexTableEntry *entry)
+    {
+        QMutexLocker locker(&m_pinLock);
+        if (entry->pinOwner != m_attachment &&
+            !entry->pinOwner.testAndSetOrdered(0, m_attachment))
+        {
+            return false;
+        }
+
+        entry->pinPid = static_cast<int>(::getpid());
+        entry->pinCount.ref();
+        m_pins.ref();
+        return true;
+    }
+
+    void unpin(qint32 index, uint generation)
+    {
+        bool removed = false;
+        {
+            CacheLocker lock(this, CacheLocker::ReadOnly);
+
+            // The cache may have been recreated in the meantime, in which
+            // case the entry is gone already.
+            if (!lock.failed() && generation == m_generation) {
+                const IndexTableEntry *entry = &shm->indexTable()[index];
+                QMutexLocker locker(&m_pinLock);
+                if (entry->pinOwner == m_attachment && entry->pinCount > 0 &&
+                    !entry->pinCount.deref())
+                {
+                    entry->pinOwner = 0;
+                    removed = entry->removed;
+                }
+            }
+        }
+
+        // The entry was cleared while pinned, and can go now.
+        if (removed) {
+            CacheLocker lock(this);
+            if (!lock.failed() && generation == m_generation) {
+                const IndexTableEntry &entry = shm->indexTable()[index];
+                if (entry.removed && entry.firstPage >= 0 && !shm->isPinned(entry)) {
+                    shm->removeEntry(index);
+                }
+            }
+        }
+
+        if (!m_pins.deref()) {
+            unmapRetired();
+        }
     }
 
     // This function does a lot of the important work, attempting to connect to shared
@@ -981,7 +1386,7 @@ class KSharedDataCache::Private
         cacheSize = qMax(pageSize * 256, cacheSize);
 
         // The m_cacheName is used to find the file to store the cache in.
-        QString cacheName = QDir::homePath() + m_cacheName + QLatin1String(".kcache");
+        QString cacheName = KSharedDataCache::cacheFileName(m_cacheName);
         QFile file(cacheName);
 
         // The basic idea is to open the file that we want to map into shared
@@ -1125,7 +1530,10 @@ class KSharedDataCache::Private
         if (!m_lock->initialize(isProcessSharingSupported)) {
             qCritical() << "Unable to setup shared cache lock, although it worked when created.";
             detachFromSharedMemory();
+            return;
         }
+
+        m_attachment = shm->attachments.fetchAndAddOrdered(1) + 1;
     }
 
     // Called whenever the cache is apparently corrupt (for instance, a timeout trying to
@@ -1140,10 +1548,10 @@ class KSharedDataCache::Private
         mapSharedMemory();
     }
 
-    bool lock() const
+    bool lock(bool shared) const
     {
         if (KDE_ISLIKELY(shm && shm->shmLock.type == m_expectedType)) {
-            return m_lock->lock();
+            return shared ? m_lock->lockShared() : m_lock->lock();
         }
 
         return false;
@@ -1157,6 +1565,8 @@ class KSharedDataCache::Private
     class CacheLocker
     {
         mutable Private * d;
+        bool m_shared;
+        QElapsedTimer m_held;
 
         bool cautiousLock()
         {
@@ -1165,19 +1575,29 @@ class KSharedDataCache::Private
             // Locking can fail due to a timeout. If it happens too often even though
             // we're taking corrective action assume there's some disastrous problem
             // and give up.
-            while (!d->lock()) {
+            while (!d->lock(m_shared)) {
+                // Recovering maps the cache again, which no other thread
+                // may be reading meanwhile.
+                d->m_mapLock.unlock();
+                d->m_mapLock.lockForWrite();
                 d->recoverCorruptedCache();
 
+                bool giveUp = false;
                 if (!d->shm) {
                     qWarning() << "Lost the connection to shared memory for cache"
                                   << d->m_cacheName;
-                    return false;
+                    giveUp = true;
                 }
-
-                if (lockCount++ > 4) {
+                else if (lockCount++ > 4) {
                     qCritical() << "There is a very serious problem with the KDE data cache"
                                 << d->m_cacheName << "giving up trying to access cache.";
                     d->detachFromSharedMemory();
+                    giveUp = true;
+                }
+
+                d->m_mapLock.unlock();
+                d->m_mapLock.lockForRead();
+                if (giveUp) {
                     return false;
                 }
             }
@@ -1186,12 +1606,28 @@ class KSharedDataCache::Private
         }
 
         public:
-        CacheLocker(const Private *_d) : d(const_cast<Private *>(_d))
+        // ReadOnly lets other lookups hold the lock at the same time, so the
+        // segment must not be changed but for the atomic fields of the index.
+        enum Access
+        {
+            ReadWrite,
+            ReadOnly
+        };
+
+        CacheLocker(const Private *_d, Access access = ReadWrite)
+            : d(const_cast<Private *>(_d))
+            , m_shared(access == ReadOnly)
         {
+            // Other threads of this process may hold the cache lock at the
+            // same time for lookups, so the mapping is only changed while
+            // none of them is in a CacheLocker.
+            d->m_mapLock.lockForRead();
+
             if (d->shm) {
                 if (!cautiousLock()) {
                     return;
                 }
+                m_held.start();
 
                 uint testSize = SharedMemory::totalSize(d->shm->cacheSize, d->shm->cachePageSize());
 
@@ -1201,48 +1637,19 @@ class KSharedDataCache::Private
                     qDebug() << "Someone enlarged the cache on us,"
                                 << "attempting to match new configuration.";
 
-                    // Protect against two threads accessing this same KSDC
-                    // from trying to execute the following remapping at the
-                    // same time.
-                    QMutexLocker d_locker(&d->m_threadLock);
-                    if (testSize == d->m_mapSize) {
-                        break; // Bail if the other thread already solved.
-                    }
-
-                    // Linux supports mremap, but it's not portable. So,
-                    // drop the map and (try to) re-establish.
+                    // The cache lock is released to map the cache again,
+                    // which waits for the other threads to leave it.
                     d->unlock();
+                    d->m_mapLock.unlock();
+                    d->m_mapLock.lockForWrite();
+                    d->remap();
+                    d->m_mapLock.unlock();
+                    d->m_mapLock.lockForRead();
 
-#ifdef KSDC_MSYNC_SUPPORTED
-                    ::msync(d->shm, d->m_mapSize, MS_INVALIDATE | MS_ASYNC);
-#endif
-                    ::munmap(d->shm, d->m_mapSize);
-                    d->m_mapSize = 0;
-                    d->shm = 0;
-
-                    QFile f(d->m_cacheName);
-                    if (!f.open(QFile::ReadWrite)) {
-                        qCritical() << "Unable to re-open cache, unfortunately"
-                                    << "the connection had to be dropped for"
-                                    << "crash safety -- things will be much"
-                                    << "slower now.";
-                        return;
-                    }
-
-                    void *newMap = ::mmap(0, testSize, PROT_READ | PROT_WRITE,
-                                          MAP_SHARED, f.handle(), 0);
-                    if (newMap == MAP_FAILED) {
-                        qCritical() << "Unopen to re-map the cache into memory"
-                                    << "things will be much slower now";
-                        return;
-                    }
-
-                    d->shm = reinterpret_cast<SharedMemory *>(newMap);
-                    d->m_mapSize = testSize;
-
-                    if (!cautiousLock()) {
+                    if (!d->shm || !cautiousLock()) {
                         return;
                     }
+                    m_held.start();
 
                     testSize = SharedMemory::totalSize(d->shm->cacheSize, d->shm->cachePageSize());
                 }
@@ -1252,8 +1659,11 @@ class KSharedDataCache::Private
         ~CacheLocker()
         {
             if (d->shm) {
+                d->shm->lockCount.add(1);
+                d->shm->lockTime.add(m_held.nsecsElapsed());
                 d->unlock();
             }
+            d->m_mapLock.unlock();
         }
 
         bool failed() const
@@ -1263,10 +1673,22 @@ class KSharedDataCache::Private
     };
 
     QString m_cacheName;
-    QMutex m_threadLock;
+
+    // Held for reading by each CacheLocker of this process, and for
+    // writing to change the mapping of the cache.
+    QReadWriteLock m_mapLock;
+
+    // Entries pinned by this process, and the mappings they keep alive
+    QAtomicInt m_pins;
+    QMutex m_pinLock;
+    QMutex m_retiredLock;
+    QList<QPair<void *, uint> > m_retired;
+
     SharedMemory *shm;
     QSharedPointer<KSDCLock> m_lock;
     uint m_mapSize;
+    int m_attachment; // tags the entries pinned through this mapping
+    uint m_generation; // bumped when detaching from the cache
     uint m_defaultCacheSize;
     uint m_expectedItemSize;
     SharedLockId m_expectedType;
@@ -1309,11 +1731,15 @@ void SharedMemory::removeEntry(uint index)
 
     uint entriesToRemove = intCeil(entriesIndex[index].totalItemSize, cachePageSize());
     uint savedCacheSize = cacheAvail;
-    for (uint i = firstPage; i < pageTableSize() &&
-        (uint) pageTableEntries[i].index == index; ++i)
+    for (pageID i = firstPage; i >= 0 && static_cast<uint>(i) < pageTableSize() &&
+        (uint) pageTableEntries[i].index == index && cacheAvail < pageTableSize(); )
     {
+        pageID next = pageTableEntries[i].next;
         pageTableEntries[i].index = -1;
+        pageTableEntries[i].next = -1;
         cacheAvail++;
+        compactCursor = qMin(compactCursor, i);
+        i = next;
     }
 
     if ((cacheAvail - savedCacheSize) != entriesToRemove) {
@@ -1333,12 +1759,18 @@ void SharedMemory::removeEntry(uint index)
 #endif
 
     // Update the index
+    unlink(index);
     entriesIndex[index].fileNameHash = 0;
     entriesIndex[index].totalItemSize = 0;
     entriesIndex[index].useCount = 0;
     entriesIndex[index].lastUsedTime = 0;
     entriesIndex[index].addTime = 0;
     entriesIndex[index].firstPage = -1;
+    entriesIndex[index].pinCount = 0;
+    entriesIndex[index].pinOwner = 0;
+    entriesIndex[index].pinPid = 0;
+    entriesIndex[index].removed = false;
+    entriesIndex[index].referenced = 0;
 }
 
 KSharedDataCache::KSharedDataCache(const QString &cacheName,
@@ -1360,6 +1792,12 @@ KSharedDataCache::~KSharedDataCache()
         ::munmap(d->shm, d->m_mapSize);
     }
 
+    // Any Entry still pinned is a bug of the caller at this point.
+    Q_ASSERT(d->m_pins == 0);
+    for (int i = 0; i < d->m_retired.size(); ++i) {
+        ::munmap(d->m_retired[i].first, d->m_retired[i].second);
+    }
+
     // Do not delete d->shm, it was never constructed, it's just an alias.
     d->shm = 0;
 
@@ -1375,60 +1813,30 @@ bool KSharedDataCache::insert(const QString &key, const QByteArray &data)
 
     QByteArray encodedKey = key.toUtf8();
     uint keyHash = generateHash(encodedKey);
-    uint position = keyHash % d->shm->indexTableSize();
-
-    // See if we're overwriting an existing entry.
     IndexTableEntry *indices = d->shm->indexTable();
 
-    // In order to avoid the issue of a very long-lived cache having items
-    // with a use count of 1 near-permanently, we attempt to artifically
-    // reduce the use count of long-lived items when there is high load on
-    // the cache. We do this randomly, with a weighting that makes the event
-    // impossible if load < 0.5, and guaranteed if load >= 0.96.
-    static double startCullPoint = 0.5l;
-    static double mustCullPoint = 0.96l;
-
-    // cacheAvail is in pages, cacheSize is in bytes.
-    double loadFactor = (1.0l * d->shm->cacheAvail * d->shm->cachePageSize()
-                              / d->shm->cacheSize);
-    bool cullCollisions = false;
-
-    if (KDE_ISUNLIKELY(loadFactor >= mustCullPoint)) {
-        cullCollisions = true;
-    }
-    else {
-        int tripWireValue = RAND_MAX * (loadFactor - startCullPoint) / (mustCullPoint - startCullPoint);
-        if (krandom() >= tripWireValue) {
-            cullCollisions = true;
-        }
-    }
-
-    // In case of collisions, use quadratic chaining to attempt to find an
-    // empty slot. The equation we use is
-    // position = (hash + (i + i*i) / 2) % size, where i is the probe number.
-    int probeNumber = 1;
-    while (indices[position].useCount > 0 && probeNumber < 6) {
-        // If we are "culling" old entries, see if this one is old and if so
-        // reduce its use count. If it reduces to zero then eliminate it and
-        // use its old spot.
-
-        if (cullCollisions && (::time(0) - indices[position].lastUsedTime) > 60) {
-            indices[position].useCount >>= 1;
-            if (indices[position].useCount == 0) {
-                qDebug() << "Overwriting existing old cached entry due to collision.";
-                d->shm->removeEntry(position); // Remove it first
-
-                break;
-            }
-        }
+    // Replace the entry for the same key if there is one, otherwise take a
+    // free position for the key, or the coldest entry sitting in one.
+    qint32 position = d->shm->findNamedEntry(encodedKey);
+    if (position < 0) {
+        position = d->shm->insertPosition(keyHash);
+    }
 
-        position = (keyHash + (probeNumber + probeNumber * probeNumber) / 2)
-                   % d->shm->indexTableSize();
-        probeNumber++;
+    if (position < 0) {
+        qDebug() << "Not inserting" << key << "every entry colliding with it is being read.";
+        return false;
     }
 
-    if (indices[position].useCount > 0 && indices[position].firstPage >= 0) {
-        qDebug() << "Overwriting existing cached entry due to collision.";
+    if (indices[position].firstPage >= 0) {
+        if (d->shm->isPinned(indices[position])) {
+            qDebug() << "Not overwriting" << key << "it is being read.";
+            return false;
+        }
+
+        if (indices[position].fileNameHash != keyHash) {
+            qDebug() << "Overwriting existing cached entry due to collision.";
+            d->shm->collisions.add(1);
+        }
         d->shm->removeEntry(position); // Remove it first
     }
 
@@ -1438,49 +1846,32 @@ bool KSharedDataCache::insert(const QString &key, const QByteArray &data)
     uint fileNameLength = 1 + encodedKey.length();
     uint requiredSize = fileNameLength + data.size();
     uint pagesNeeded = intCeil(requiredSize, d->shm->cachePageSize());
-    uint firstPage = (uint) -1;
 
     if (pagesNeeded >= d->shm->pageTableSize()) {
         qWarning() << key << "is too large to be cached.";
         return false;
     }
 
-    // If the cache has no room, or the fragmentation is too great to find
-    // the required number of consecutive free pages, take action.
-    if (pagesNeeded > d->shm->cacheAvail ||
-       (firstPage = d->shm->findEmptyPages(pagesNeeded)) >= d->shm->pageTableSize())
-    {
-        // If we have enough free space just defragment
+    // If the cache has no room, make some. Fragmentation does not matter,
+    // the entry can use any free pages.
+    if (pagesNeeded > d->shm->cacheAvail) {
+        // If we already have free pages we don't want to remove a ton
+        // extra, but removing a little more than needed saves doing it
+        // again on the next insert.
         uint freePagesDesired = 3 * qMax(1u, pagesNeeded / 2);
 
-        if (d->shm->cacheAvail > freePagesDesired) {
-            // TODO: How the hell long does this actually take on real
-            // caches?
-            d->shm->defragment();
-            firstPage = d->shm->findEmptyPages(pagesNeeded);
-        }
-        else {
-            // If we already have free pages we don't want to remove a ton
-            // extra. However we can't rely on the return value of
-            // removeUsedPages giving us a good location since we're not
-            // passing in the actual number of pages that we need.
-            d->shm->removeUsedPages(qMin(2 * freePagesDesired, d->shm->pageTableSize())
-                                    - d->shm->cacheAvail);
-            firstPage = d->shm->findEmptyPages(pagesNeeded);
-        }
-
-        if (firstPage >= d->shm->pageTableSize() ||
-           d->shm->cacheAvail < pagesNeeded)
+        if (!d->shm->removeUsedPages(qMin(2 * freePagesDesired, d->shm->pageTableSize())) &&
+            d->shm->cacheAvail < pagesNeeded)
         {
             qCritical() << "Unable to free up memory for" << key;
             return false;
         }
     }
 
-    // Update page table
-    PageTableEntry *table = d->shm->pageTable();
-    for (uint i = 0; i < pagesNeeded; ++i) {
-        table[firstPage + i].index = position;
+    pageID firstPage = d->shm->allocatePages(pagesNeeded, position);
+    if (firstPage < 0 || static_cast<uint>(firstPage) >= d->shm->pageTableSize()) {
+        qCritical() << "Unable to allocate memory for" << key;
+        return false;
     }
 
     // Update index
@@ -1488,19 +1879,25 @@ bool KSharedDataCache::insert(const QString &key, const QByteArray &data)
     indices[position].totalItemSize = requiredSize;
     indices[position].useCount = 1;
     indices[position].addTime = ::time(0);
-    indices[position].lastUsedTime = indices[position].addTime;
+    indices[position].lastUsedTime = static_cast<int>(indices[position].addTime);
     indices[position].firstPage = firstPage;
-
-    // Update cache
-    d->shm->cacheAvail -= pagesNeeded;
+    indices[position].pinCount = 0;
+    indices[position].pinOwner = 0;
+    indices[position].pinPid = 0;
+    indices[position].removed = false;
+    indices[position].referenced = 0;
+    d->shm->linkNewest(position);
 
     // Actually move the data in place
-    void *dataPage = d->shm->page(firstPage);
+    d->shm->writeEntry(firstPage, 0, encodedKey.constData(), fileNameLength);
+    d->shm->writeEntry(firstPage, fileNameLength, data.constData(), data.size());
+
+    d->shm->inserts.add(1);
 
-    // Cast for byte-sized pointer arithmetic
-    uchar *startOfPageData = reinterpret_cast<uchar *>(dataPage);
-    ::memcpy(startOfPageData, encodedKey.constData(), fileNameLength);
-    ::memcpy(startOfPageData + fileNameLength, data.constData(), data.size());
+    // Pay for the fragmentation a little at a time, with a bound on the
+    // work comparable to the copy above, instead of compacting the whole
+    // cache whenever a large entry does not fit.
+    d->shm->compact(qMax(8u, pagesNeeded));
 
     return true;
 }
@@ -1511,7 +1908,7 @@ bool KSharedDataCache::find(const QString &key, QByteArray *destination) const
         return false;
     }
 
-    Private::CacheLocker lock(d);
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
     if (lock.failed()) {
         return false;
     }
@@ -1522,27 +1919,131 @@ bool KSharedDataCache::find(const QString &key, QByteArray *destination) const
 
     if (entry >= 0) {
         const IndexTableEntry *header = &d->shm->indexTable()[entry];
-        const void *resultPage = d->shm->page(header->firstPage);
 
-        header->useCount++;
-        header->lastUsedTime = ::time(0);
+        header->touch();
+        d->shm->hits.add(1);
 
         // Our item is the key followed immediately by the data, so skip
-        // past the key.
-        const char *cacheData = reinterpret_cast<const char *>(resultPage);
-        cacheData += encodedKey.size();
-        cacheData++; // Skip trailing null -- now we're pointing to start of data
-
+        // past the key and its trailing null.
         if (destination) {
-            *destination = QByteArray(cacheData, header->totalItemSize - encodedKey.size() - 1);
+            uint dataOffset = encodedKey.size() + 1;
+            QByteArray data;
+            data.resize(header->totalItemSize - dataOffset);
+            d->shm->readEntry(entry, dataOffset, data.data(), data.size());
+            *destination = data;
         }
 
         return true;
     }
 
+    d->shm->misses.add(1);
     return false;
 }
 
+bool KSharedDataCache::findEntry(const QString &key, Entry *entry) const
+{
+    if (!entry) {
+        return find(key, 0);
+    }
+
+    entry->release();
+
+    if (!d->shm) {
+        return false;
+    }
+
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
+    if (lock.failed()) {
+        return false;
+    }
+
+    QByteArray encodedKey = key.toUtf8();
+    qint32 index = d->shm->findNamedEntry(encodedKey);
+
+    if (index < 0) {
+        d->shm->misses.add(1);
+        return false;
+    }
+
+    const IndexTableEntry *header = &d->shm->indexTable()[index];
+    uint dataOffset = encodedKey.size() + 1;
+
+    header->touch();
+    d->shm->hits.add(1);
+    entry->m_size = header->totalItemSize - dataOffset;
+
+    // Data spread over a chain of pages has to be copied to be seen in one
+    // piece, and then there is no need to pin it. So does data another
+    // attachment of the cache has pinned.
+    if (!d->shm->isContiguous(index) || !d->pin(header)) {
+        entry->m_copy.resize(entry->m_size);
+        d->shm->readEntry(index, dataOffset, entry->m_copy.data(), entry->m_size);
+        entry->m_data = entry->m_copy.constData();
+        return true;
+    }
+
+    // Skip past the key and its trailing null, as find() does.
+    entry->m_cache = this;
+    entry->m_index = index;
+    entry->m_generation = d->m_generation;
+    entry->m_data = reinterpret_cast<const char *>(d->shm->page(header->firstPage)) + dataOffset;
+
+    return true;
+}
+
+KSharedDataCache::Entry::Entry()
+    : m_cache(0)
+    , m_index(-1)
+    , m_generation(0)
+    , m_data(0)
+    , m_size(0)
+{
+}
+
+KSharedDataCache::Entry::~Entry()
+{
+    release();
+}
+
+bool KSharedDataCache::Entry::isNull() const
+{
+    return m_data == 0;
+}
+
+const char *KSharedDataCache::Entry::constData() const
+{
+    return m_data;
+}
+
+unsigned KSharedDataCache::Entry::size() const
+{
+    return m_size;
+}
+
+void KSharedDataCache::Entry::release()
+{
+    if (m_cache) {
+        m_cache->d->unpin(m_index, m_generation);
+    }
+
+    m_cache = 0;
+    m_index = -1;
+    m_generation = 0;
+    m_data = 0;
+    m_size = 0;
+    m_copy.clear();
+}
+
+bool KSharedDataCache::compact(unsigned maxPages)
+{
+    Private::CacheLocker lock(d);
+    if (lock.failed()) {
+        return true;
+    }
+
+    return d->shm->compact(maxPages);
+}
+
 void KSharedDataCache::clear()
 {
     Private::CacheLocker lock(d);
@@ -1554,7 +2055,7 @@ void KSharedDataCache::clear()
 
 bool KSharedDataCache::contains(const QString &key) const
 {
-    Private::CacheLocker lock(d);
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
     if (lock.failed()) {
         return false;
     }
@@ -1564,7 +2065,7 @@ bool KSharedDataCache::contains(const QString &key) const
 
 void KSharedDataCache::deleteCache(const QString &cacheName)
 {
-    QString cachePath = QDir::homePath() + cacheName + QLatin1String(".kcache");
+    QString cachePath = cacheFileName(cacheName);
 
     // Note that it is important to simply unlink the file, and not truncate it
     // smaller first to avoid SIGBUS errors and similar with shared memory
@@ -1573,9 +2074,14 @@ void KSharedDataCache::deleteCache(const QString &cacheName)
     QFile::remove(cachePath);
 }
 
+QString KSharedDataCache::cacheFileName(const QString &cacheName)
+{
+    return QDir::homePath() + cacheName + QLatin1String(".kcache");
+}
+
 unsigned KSharedDataCache::totalSize() const
 {
-    Private::CacheLocker lock(d);
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
     if (lock.failed()) {
         return 0u;
     }
@@ -1585,7 +2091,7 @@ unsigned KSharedDataCache::totalSize() const
 
 unsigned KSharedDataCache::freeSize() const
 {
-    Private::CacheLocker lock(d);
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
     if (lock.failed()) {
         return 0u;
     }
@@ -1624,3 +2130,61 @@ void KSharedDataCache::setTimestamp(unsigned newTimestamp)
         d->shm->cacheTimestamp.fetchAndStoreRelease(static_cast<int>(newTimestamp));
     }
 }
+
+KSharedDataCache::Statistics::Statistics()
+    : hits(0), misses(0), inserts(0), evictions(0), collisions(0),
+      compactions(0), pagesMoved(0), lockCount(0), lockTime(0),
+      entries(0), itemBytes(0), pageSize(0)
+{
+}
+
+KSharedDataCache::Statistics KSharedDataCache::statistics() const
+{
+    Statistics stats;
+
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadOnly);
+    if (lock.failed()) {
+        return stats;
+    }
+
+    const SharedMemory *shm = d->shm;
+    stats.hits = shm->hits.value();
+    stats.misses = shm->misses.value();
+    stats.inserts = shm->inserts.value();
+    stats.evictions = shm->evictions.value();
+    stats.collisions = shm->collisions.value();
+    stats.compactions = shm->compactions.value();
+    stats.pagesMoved = shm->pagesMoved.value();
+    stats.lockCount = shm->lockCount.value();
+    stats.lockTime = shm->lockTime.value();
+    stats.pageSize = shm->cachePageSize();
+
+    const IndexTableEntry *indices = shm->indexTable();
+    for (uint i = 0; i < shm->indexTableSize(); ++i) {
+        if (indices[i].firstPage >= 0) {
+            ++stats.entries;
+            stats.itemBytes += indices[i].totalItemSize;
+        }
+    }
+
+    return stats;
+}
+
+void KSharedDataCache::resetStatistics()
+{
+    Private::CacheLocker lock(d, Private::CacheLocker::ReadWrite);
+    if (lock.failed()) {
+        return;
+    }
+
+    SharedMemory *shm = d->shm;
+    shm->hits.reset();
+    shm->misses.reset();
+    shm->inserts.reset();
+    shm->evictions.reset();
+    shm->collisions.reset();
+    shm->compactions.reset();
+    shm->pagesMoved.reset();
+    shm->lockCount.reset();
+    shm->lockTime.reset();
+}
@@ -20,10 +20,10 @@
 #ifndef KSHAREDDATACACHE_H
 #define KSHAREDDATACACHE_H
 
+#include <QtCore/QByteArray>
+
 class QString;
-class QByteArray;
 
-int krandom();
 /**
  * @brief A simple data cache which uses shared memory to quickly access data
  * stored on disk.
@@ -130,11 +130,97 @@ public:
      */
     bool find(const QString &key, QByteArray *destination) const;
 
+    /**
+     * A read-only view of the data of a cache entry, directly in shared
+     * memory.
+     *
+     * As long as an Entry refers to the data, the cache entry is pinned: no
+     * process sharing the cache evicts, overwrites or moves it. (Entries
+     * too fragmented to be viewed in place, or pinned by another
+     * KSharedDataCache, are copied instead.) Pinned
+     * entries cannot make room for new ones, so release an Entry as soon as
+     * the data is no longer needed, and never keep one past the lifetime of
+     * the cache it was found in.
+     *
+     * @see findEntry()
+     */
+    class Entry
+    {
+    public:
+        Entry();
+        ~Entry();
+
+        /**
+         * @return true if this Entry does not refer to any data.
+         */
+        bool isNull() const;
+
+        /**
+         * @return The data of the entry, valid until release().
+         */
+        const char *constData() const;
+
+        /**
+         * @return The size of the data of the entry, in bytes.
+         */
+        unsigned size() const;
+
+        /**
+         * Unpins the cache entry. constData() must not be used afterwards.
+         */
+        void release();
+
+    private:
+        friend class KSharedDataCache;
+
+        Entry(const Entry &);
+        Entry &operator=(const Entry &);
+
+        const KSharedDataCache *m_cache;
+        int m_index;
+        unsigned m_generation;
+        const char *m_data;
+        unsigned m_size;
+        QByteArray m_copy; // when the entry is not in consecutive pages
+    };
+
+    /**
+     * Finds the data in the cache named by @p key like find() does, but
+     * without copying it: @p entry is set to refer to the data in shared
+     * memory, and pins the cache entry until it is released.
+     *
+     * Example:
+     * @code
+     * KSharedDataCache::Entry entry;
+     * if (cache->findEntry(key, &entry)) {
+     *     parse(entry.constData(), entry.size());
+     * }
+     * @endcode
+     *
+     * @param key The key to find in the cache.
+     * @param entry Is released, then set to the entry named by @p key if
+     *              @p key is present.
+     * @return true if @p key was present in the cache, false otherwise.
+     */
+    bool findEntry(const QString &key, Entry *entry) const;
+
     /**
      * Removes all entries from the cache.
      */
     void clear();
 
+    /**
+     * Moves data around in the cache so that its free space ends up in one
+     * piece, and entries in consecutive pages, which is what findEntry()
+     * needs to work without copying. Every insert already does a bounded
+     * amount of this work; call this when the application is idle to catch
+     * up.
+     *
+     * @param maxPages The largest number of pages of data to move.
+     * @return true if the cache is compact, false if there is more to do.
+     */
+    bool compact(unsigned maxPages = 64);
+
     /**
      * Removes the underlying file from the cache. Note that this is *all* that this
      * function does. The shared memory segment is still attached and will still contain
@@ -144,6 +230,12 @@ public:
      */
     static void deleteCache(const QString &cacheName);
 
+    /**
+     * @return The path of the file holding the cache named @p cacheName,
+     *         whether it exists or not.
+     */
+    static QString cacheFileName(const QString &cacheName);
+
     /**
      * Returns true if the cache currently contains the image for the given
      * filename.
@@ -213,6 +305,41 @@ public:
      */
     void setTimestamp(unsigned newTimestamp);
 
+    /**
+     * Usage counts of a cache, kept in the cache itself, and so shared by
+     * every process using it. Counts start when the cache is created or
+     * resetStatistics() is called, and are not reset by clear().
+     */
+    struct Statistics
+    {
+        Statistics();
+
+        quint64 hits;        ///< find() and findEntry() calls that found their key
+        quint64 misses;      ///< find() and findEntry() calls that did not
+        quint64 inserts;     ///< successful insert() calls
+        quint64 evictions;   ///< entries removed to make room for others
+        quint64 collisions;  ///< entries overwritten by another key hashing alike
+        quint64 compactions; ///< compaction steps that moved data
+        quint64 pagesMoved;  ///< pages of data moved by compaction
+        quint64 lockCount;   ///< times the cache was locked
+        quint64 lockTime;    ///< nanoseconds the cache was held locked, in total
+
+        unsigned entries;    ///< entries in the cache now
+        unsigned itemBytes;  ///< size of the keys and data of these entries
+        unsigned pageSize;   ///< size of the pages the cache is made of
+    };
+
+    /**
+     * @return The usage counts of the cache, all 0 if it could not be
+     *         locked.
+     */
+    Statistics statistics() const;
+
+    /**
+     * Sets the usage counts of the cache back to 0.
+     */
+    void resetStatistics();
+
 private:
     class Private;
     Private *d;
@@ -107,6 +107,14 @@ public:
         return false;
     }
 
+    // Locks for readers only, which may hold the lock together. Locks that
+    // cannot tell readers apart simply lock.
+    virtual bool lockShared()
+    {
+        return lock();
+    }
+
+    // Releases the lock, however it was taken.
     virtual void unlock()
     {
     }
@@ -185,6 +193,95 @@ public:
 };
 #endif
 
+#ifdef KSDC_THREAD_PROCESS_SHARED_SUPPORTED
+class pthreadRWLock : public KSDCLock
+{
+public:
+    pthreadRWLock(pthread_rwlock_t &rwlock)
+        : m_rwlock(rwlock)
+    {
+    }
+
+    virtual bool initialize(bool &processSharingSupported)
+    {
+        // Setup process-sharing.
+        pthread_rwlockattr_t rwlockAttr;
+        processSharingSupported = false;
+
+        if (::sysconf(_SC_THREAD_PROCESS_SHARED) >= 200112L && pthread_rwlockattr_init(&rwlockAttr) == 0) {
+#ifdef __GLIBC__
+            // Lookups come and go all the time, they must not starve inserts.
+            pthread_rwlockattr_setkind_np(&rwlockAttr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+            if (pthread_rwlockattr_setpshared(&rwlockAttr, PTHREAD_PROCESS_SHARED) == 0 &&
+                pthread_rwlock_init(&m_rwlock, &rwlockAttr) == 0)
+            {
+                processSharingSupported = true;
+            }
+            pthread_rwlockattr_destroy(&rwlockAttr);
+        }
+
+        // Attempt to setup for thread-only synchronization.
+        if (!processSharingSupported && pthread_rwlock_init(&m_rwlock, NULL) != 0) {
+            return false;
+        }
+
+        return true;
+    }
+
+    virtual bool lock()
+    {
+        return pthread_rwlock_wrlock(&m_rwlock) == 0;
+    }
+
+    virtual bool lockShared()
+    {
+        return pthread_rwlock_rdlock(&m_rwlock) == 0;
+    }
+
+    virtual void unlock()
+    {
+        pthread_rwlock_unlock(&m_rwlock);
+    }
+
+protected:
+    pthread_rwlock_t &m_rwlock;
+};
+#endif
+
+#if defined(KSDC_THREAD_PROCESS_SHARED_SUPPORTED) && defined(KSDC_TIMEOUTS_SUPPORTED)
+class pthreadTimedRWLock : public pthreadRWLock
+{
+public:
+    pthreadTimedRWLock(pthread_rwlock_t &rwlock)
+        : pthreadRWLock(rwlock)
+    {
+    }
+
+    virtual bool lock()
+    {
+        struct timespec timeout = lockTimeout();
+        return pthread_rwlock_timedwrlock(&m_rwlock, &timeout) == 0;
+    }
+
+    virtual bool lockShared()
+    {
+        struct timespec timeout = lockTimeout();
+        return pthread_rwlock_timedrdlock(&m_rwlock, &timeout) == 0;
+    }
+
+private:
+    static struct timespec lockTimeout()
+    {
+        // Same reasoning as for pthreadTimedLock.
+        struct timespec timeout;
+        timeout.tv_sec = 10 + ::time(NULL); // Absolute time, so 10 seconds from now
+        timeout.tv_nsec = 0;
+        return timeout;
+    }
+};
+#endif
+
 #ifdef KSDC_SEMAPHORES_SUPPORTED
 class semaphoreLock : public KSDCLock
 {
@@ -258,7 +355,8 @@ public:
 // a versioned field, do not re-arrange.
 enum SharedLockId {
     LOCKTYPE_MUTEX     = 1,  // pthread_mutex
-    LOCKTYPE_SEMAPHORE = 2   // sem_t
+    LOCKTYPE_SEMAPHORE = 2,  // sem_t
+    LOCKTYPE_RWLOCK    = 3   // pthread_rwlock
 };
 
 // This type is a union of all possible lock types, with a SharedLockId used
@@ -269,6 +367,7 @@ struct SharedLock
     {
 #if defined(KSDC_THREAD_PROCESS_SHARED_SUPPORTED)
         pthread_mutex_t mutex;
+        pthread_rwlock_t rwlock;
 #endif
 #if defined(KSDC_SEMAPHORES_SUPPORTED)
         sem_t semaphore;
@@ -298,6 +397,7 @@ static SharedLockId findBestSharedLock()
     bool semaphoresSupported = false;
     bool timeoutsSupported = false;
     bool pthreadsProcessShared = false;
+    bool rwlocksProcessShared = false;
     bool semaphoresProcessShared = false;
 
 #ifdef KSDC_TIMEOUTS_SUPPORTED
@@ -323,7 +423,28 @@ static SharedLockId findBestSharedLock()
     }
 #endif
 
-    // Our first choice is pthread_mutex_t for compatibility.
+    // Our first choice is pthread_rwlock_t, which lets lookups run
+    // concurrently, then pthread_mutex_t for compatibility.
+#ifdef KSDC_THREAD_PROCESS_SHARED_SUPPORTED
+    if (pthreadsSupported) {
+        pthread_rwlock_t tempRWLock;
+        QSharedPointer<KSDCLock> tempLock(0);
+        if (timeoutsSupported) {
+#ifdef KSDC_TIMEOUTS_SUPPORTED
+            tempLock = QSharedPointer<KSDCLock>(new pthreadTimedRWLock(tempRWLock));
+#endif
+        }
+        else {
+            tempLock = QSharedPointer<KSDCLock>(new pthreadRWLock(tempRWLock));
+        }
+
+        tempLock->initialize(rwlocksProcessShared);
+    }
+#endif
+
+    if(timeoutsSupported && rwlocksProcessShared) {
+        return LOCKTYPE_RWLOCK;
+    }
     if(timeoutsSupported && pthreadsProcessShared) {
         return LOCKTYPE_MUTEX;
     }
@@ -346,6 +467,9 @@ static SharedLockId findBestSharedLock()
     if(timeoutsSupported && semaphoresProcessShared) {
         return LOCKTYPE_SEMAPHORE;
     }
+    else if(rwlocksProcessShared) {
+        return LOCKTYPE_RWLOCK;
+    }
     else if(pthreadsProcessShared) {
         return LOCKTYPE_MUTEX;
     }
@@ -377,6 +501,16 @@ static KSDCLock *createLockFromId(SharedLockId id, SharedLock &lock)
         return new pthreadLock(lock.mutex);
 
     break;
+
+    case LOCKTYPE_RWLOCK:
+#ifdef KSDC_TIMEOUTS_SUPPORTED
+        if (::sysconf(_SC_TIMEOUTS) >= 200112L) {
+            return new pthreadTimedRWLock(lock.rwlock);
+        }
+#endif
+        return new pthreadRWLock(lock.rwlock);
+
+    break;
 #endif
 
 #ifdef KSDC_SEMAPHORES_SUPPORTED
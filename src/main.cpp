@@ -2,6 +2,7 @@
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QStringList>
 
 int main(int argc, char *argv[])
 {
@@ -9,7 +10,44 @@ int main(int argc, char *argv[])
 
     qRegisterMetaType<Coord>("Coord");
 
+    // game parameters: --board WIDTHxHEIGHT --fleet SIZE,SIZE,...
+    // tile sizes to render the theme at in the background: --prerender SIZE,SIZE,...
+    GameSettings settings;
+    QList<int> prerenderSizes;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i += 2) {
+        QString value = i + 1 < args.size() ? args[i + 1] : QString();
+        bool ok = false;
+        if (args[i] == "--board") {
+            ok = settings.parseSize(value);
+        }
+        else if (args[i] == "--fleet") {
+            ok = settings.parseFleet(value);
+        }
+        else if (args[i] == "--prerender") {
+            ok = true;
+            foreach (const QString& size, value.split(',')) {
+                prerenderSizes.append(size.toInt(&ok));
+                if (!ok) {
+                    break;
+                }
+            }
+        }
+        if (!ok) {
+            qWarning("unknown or malformed option %s", qPrintable(args[i]));
+            return 1;
+        }
+    }
+    if (!settings.valid()) {
+        qWarning("the fleet does not fit on a %dx%d board (at most %dx%d)",
+                 settings.size().x, settings.size().y,
+                 GameSettings::MAX_SIZE, GameSettings::MAX_SIZE);
+        return 1;
+    }
+
     MainWindow w;
+    w.setGameSettings(settings);
+    w.setPrerenderSizes(prerenderSizes);
 #ifndef DEBUG
     w.showFullScreen();
 #else
@@ -43,6 +43,16 @@ MainWindow::~MainWindow()
 {
 }
 
+void MainWindow::setGameSettings(const GameSettings& settings)
+{
+    m_main->setGameSettings(settings);
+}
+
+void MainWindow::setPrerenderSizes(const QList<int>& sizes)
+{
+    m_main->setPrerenderSizes(sizes);
+}
+
 void MainWindow::startingGame()
 {
     m_started = true;
@@ -3,6 +3,8 @@
 
 #include "ui_mainwindow.h"
 
+#include "gamesettings.h"
+
 #include <QMainWindow>
 
 
@@ -16,6 +18,9 @@ public:
     MainWindow(QWidget *parent = 0, Qt::WindowFlags flags = 0);
     virtual ~MainWindow();
 
+    void setGameSettings(const GameSettings& settings);
+    void setPrerenderSizes(const QList<int>& sizes);
+
 private:
     PlayField *m_main;
     bool m_started;
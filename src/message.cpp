@@ -9,6 +9,8 @@
 
 #include "message.h"
 
+#include <QStringList>
+
 HeaderMessage::HeaderMessage(const QString& protocolVersion,
                              const QString& clientName,
                              const QString& clientVersion,
@@ -21,7 +23,7 @@ HeaderMessage::HeaderMessage(const QString& protocolVersion,
 }
 
 HeaderMessage::HeaderMessage()
-: m_protocol_version("0.1.0")
+: m_protocol_version("0.3.0")
 , m_client_name("KBattleship")
 , m_client_version("4.0")
 , m_client_description("The Naval Battle game")
@@ -33,6 +35,34 @@ void HeaderMessage::accept(MessageVisitor& visitor) const
     visitor.visit(*this);
 }
 
+/**
+ * Compare dotted versions part by part, as numbers: 0.10.0 is after 0.9.0.
+ * Missing parts count as 0.
+ */
+static bool versionAtLeast(const QString& version, const QString& minimum)
+{
+    QStringList parts = version.split('.');
+    QStringList minimumParts = minimum.split('.');
+    for (int i = 0; i < qMax(parts.size(), minimumParts.size()); i++) {
+        int part = i < parts.size() ? parts[i].toInt() : 0;
+        int minimumPart = i < minimumParts.size() ? minimumParts[i].toInt() : 0;
+        if (part != minimumPart) {
+            return part > minimumPart;
+        }
+    }
+    return true;
+}
+
+bool HeaderMessage::supportsOptions() const
+{
+    return versionAtLeast(m_protocol_version, "0.2.0");
+}
+
+bool HeaderMessage::supportsBinary() const
+{
+    return versionAtLeast(m_protocol_version, "0.3.0");
+}
+
 RejectMessage::RejectMessage(bool versionMismatch, const QString& reason)
 : m_version_mismatch(versionMismatch)
 , m_reason(reason)
@@ -89,6 +119,17 @@ void GameOverMessage::addShip(const Coord& pos, int size, Ship::Direction direct
     m_ships.append(ShipInfo(pos, size, direction));
 }
 
+GameOptionsMessage::GameOptionsMessage(const GameSettings& settings, bool clientFirst)
+: m_settings(settings)
+, m_client_first(clientFirst)
+{
+}
+
+void GameOptionsMessage::accept(MessageVisitor& visitor) const
+{
+    visitor.visit(*this);
+}
+
 void GameOverMessage::accept(MessageVisitor& visitor) const
 {
     visitor.visit(*this);
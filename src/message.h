@@ -10,6 +10,7 @@
 #ifndef MESSAGE_H
 #define MESSAGE_H
 
+#include "gamesettings.h"
 #include "ksharedptr.h"
 #include "ship.h"
 
@@ -38,6 +39,16 @@ public:
                  const QString& clientDescription);
     HeaderMessage();
     virtual void accept(MessageVisitor& visitor) const;
+
+    /**
+     * @return whether the sender understands GameOptionsMessage
+     */
+    bool supportsOptions() const;
+
+    /**
+     * @return whether the sender can read binary frames
+     */
+    bool supportsBinary() const;
     
     const QString& protocolVersion() const { return m_protocol_version; }
     const QString& clientName() const { return m_client_name; }
@@ -53,6 +64,9 @@ public:
     static const int MSGTYPE = 1;
     RejectMessage(bool versionMismatch, const QString& reason);
     virtual void accept(MessageVisitor& visitor) const;
+
+    bool versionMismatch() const { return m_version_mismatch; }
+    const QString& reason() const { return m_reason; }
 };
 
 class BeginMessage : public Message
@@ -129,6 +143,28 @@ public:
 };
 
 
+/**
+ * Sent by the host after the header of the client, to set the board
+ * size and fleet of the game.
+ */
+class GameOptionsMessage : public Message
+{
+    GameSettings m_settings;
+    bool m_client_first;
+public:
+    static const int MSGTYPE = 8;
+    explicit GameOptionsMessage(const GameSettings& settings, bool clientFirst = false);
+    virtual void accept(MessageVisitor& visitor) const;
+
+    const GameSettings& settings() const { return m_settings; }
+
+    /**
+     * @return whether the client moves first, rather than the host;
+     *         only understood by clients that support binary frames
+     */
+    bool clientFirst() const { return m_client_first; }
+};
+
 class MessageVisitor
 {
 public:
@@ -140,6 +176,7 @@ public:
     virtual void visit(const NotificationMessage& msg) = 0;
     virtual void visit(const GameOverMessage& msg) = 0;
     virtual void visit(const RestartMessage& msg) = 0;
+    virtual void visit(const GameOptionsMessage& msg) = 0;
 };
 
 #endif // MESSAGE_H
@@ -19,6 +19,7 @@
 NetworkEntity::NetworkEntity(Sea::Player player, Sea* sea, Protocol* protocol, bool client)
 : Entity(player)
 , m_sea(sea)
+, m_pending_shot(0)
 , m_client(client)
 {
     m_protocol = protocol;
@@ -35,7 +36,10 @@ void NetworkEntity::start(bool ask)
 
     if (ask)
         m_protocol->send(MessagePtr(new RestartMessage()));
-    else
+
+    // the host answers the header of the client with the game options,
+    // so the client introduces itself on every start
+    if (!ask || m_client)
         m_protocol->send(MessagePtr(new HeaderMessage()));
 }
 
@@ -102,6 +106,20 @@ void NetworkEntity::visit(const HeaderMessage& msg)
     if (msg.clientName() == "KBattleship" && msg.clientVersion().toFloat() >= 4.0) {
         // m_level = COMPAT_KBS4;
     }
+
+    if (m_client) {
+        return;
+    }
+
+    // we are hosting: the client plays with our settings
+    if (msg.supportsOptions()) {
+        m_protocol->send(MessagePtr(new GameOptionsMessage(m_sea->settings())));
+    }
+    else if (m_sea->settings() != GameSettings()) {
+        m_protocol->send(MessagePtr(new RejectMessage(true,
+            "Board size and fleet not supported by the client")));
+        emit abortGame();
+    }
 }
 
 void NetworkEntity::visit(const RejectMessage&)
@@ -111,7 +129,7 @@ void NetworkEntity::visit(const RejectMessage&)
 
 void NetworkEntity::visit(const BeginMessage&)
 {
-    m_sea->add(m_player, 4);
+    m_sea->add(m_player, m_sea->settings().ships());
     emit ready(m_player);
 }
 
@@ -131,6 +149,15 @@ void NetworkEntity::visit(const NotificationMessage& msg)
             if (msg.death()) {
                 // gather ship data
                 Coord delta = msg.stop() - msg.start();
+                if (!m_sea->valid(m_player, msg.start())
+                    || !m_sea->valid(m_player, msg.stop())
+                    || (delta.x != 0 && delta.y != 0)) {
+                    m_pending_shot->execute(HitInfo::INVALID);
+                    m_pending_shot = 0;
+                    emit abortGame();
+                    return;
+                }
+
                 int size = abs(delta.x) + abs(delta.y) + 1;
                 Ship::Direction direction = delta.x == 0 ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT;
                 Coord shipPos = (delta.x < 0 || delta.y < 0) ? msg.stop() : msg.start();
@@ -158,6 +185,24 @@ void NetworkEntity::visit(const RestartMessage&)
     emit restartRequested();
 }
 
+void NetworkEntity::visit(const GameOptionsMessage& msg)
+{
+    if (!m_client) {
+        return;
+    }
+
+    if (msg.settings().valid()) {
+        emit settingsChanged(msg.settings());
+        if (msg.clientFirst()) {
+            emit firstMove(Sea::opponent(m_player));
+        }
+    }
+    else {
+        qDebug() << "invalid game options from the host";
+        emit abortGame();
+    }
+}
+
 QIcon NetworkEntity::icon() const
 {
     return QIcon("network-workgroup");
@@ -45,8 +45,11 @@ protected:
     virtual void visit(const NotificationMessage& msg);
     virtual void visit(const GameOverMessage& msg);
     virtual void visit(const RestartMessage& msg);
+    virtual void visit(const GameOptionsMessage& msg);
 signals:
     void restartRequested();
+    void settingsChanged(const GameSettings& settings);
+    void firstMove(int player);
 };
 
 #endif // NETWORKENTITY_H
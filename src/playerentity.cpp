@@ -70,12 +70,15 @@ void PlayerEntity::action(Sea::Player player, const Coord& c)
 
 void PlayerEntity::start(bool ask)
 {
-    m_ships.append(new Ship(1, Ship::LEFT_TO_RIGHT));
-    m_ships.append(new Ship(2, Ship::LEFT_TO_RIGHT));
-    m_ships.append(new Ship(3, Ship::LEFT_TO_RIGHT));
-    m_ships.append(new Ship(4, Ship::LEFT_TO_RIGHT));
-
     UIEntity::start(ask);
+
+    // ships still to place
+    qDeleteAll(m_ships);
+    m_ships.clear();
+    foreach (unsigned int size, m_sea->settings().fleet()) {
+        m_ships.append(new Ship(size, Ship::LEFT_TO_RIGHT));
+    }
+
     m_view->setDelegate(this);
 }
 
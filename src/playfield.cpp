@@ -50,9 +50,19 @@ PlayField::~PlayField()
     delete m_controller;
 }
 
+void PlayField::setGameSettings(const GameSettings& settings)
+{
+    m_settings = settings;
+}
+
+void PlayField::setPrerenderSizes(const QList<int>& sizes)
+{
+    m_sea->setPrerenderSizes(sizes);
+}
+
 Controller* PlayField::createController()
 {
-    Controller* controller = new Controller(this);
+    Controller* controller = new Controller(this, m_settings);
     connect(controller, SIGNAL(gameOver(Sea::Player)),
             this, SLOT(gameOver(Sea::Player)));
     connect(controller, SIGNAL(gameAbort()),
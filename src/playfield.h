@@ -27,6 +27,7 @@ Q_OBJECT
     SimpleMenu* m_menu;
     QStatusBar* m_status_bar;
     bool m_show_endofgame_message;
+    GameSettings m_settings;
 
     void startGame();
     void endGame();
@@ -36,6 +37,17 @@ Q_OBJECT
 public:
     PlayField(QWidget* parent, QStatusBar*);
     ~PlayField();
+
+    /**
+     * Board size and fleet of the games started from now on. When
+     * joining a network game, those of the host are used instead.
+     */
+    void setGameSettings(const GameSettings& settings);
+
+    /**
+     * Tile sizes to prerender the theme at, see SeaView::setPrerenderSizes().
+     */
+    void setPrerenderSizes(const QList<int>& sizes);
 public slots:
     void gameAbort();
     void gameOver(Sea::Player winner);
@@ -13,7 +13,9 @@
 
 #include <QDomElement>
 #include <QDomNode>
+#include <QIODevice>
 #include <QStringList>
+#include <QXmlStreamReader>
 
 #define ADD_FIELD(msg, field) addField(#field, msg.field())
 class MessageSender : public MessageVisitor
@@ -95,152 +97,796 @@ public:
     {
         setType(msg);
     }
+
+    virtual void visit(const GameOptionsMessage& msg)
+    {
+        setType(msg);
+        const GameSettings& settings = msg.settings();
+        addField("boardwidth", QString::number(settings.size().x));
+        addField("boardheight", QString::number(settings.size().y));
+        QStringList fleet;
+        foreach (unsigned int ship, settings.fleet()) {
+            fleet << QString::number(ship);
+        }
+        addField("fleet", fleet.join(QLatin1String(" ")));
+        if (msg.clientFirst()) {
+            addField("clientfirst", "true");
+        }
+    }
 };
 
 
 
-Protocol::Protocol(QIODevice* device)
-: m_device(device)
+/**
+ * Fields of the message being decoded. Every field of every message
+ * type has its own slot, so fields may come in any order, and the
+ * message is built from them once its closing tag is read.
+ */
+struct MessageFields
 {
-    m_device->setParent(this);
-    m_timer.start(100);
-    connect(m_device, SIGNAL(disconnected()), this, SLOT(processDisconnection()));
-    connect(m_device, SIGNAL(readyRead()), this, SLOT(readMore()));
-    connect(&m_timer, SIGNAL(timeout()), this, SLOT(sendNext()));
+    int type;
+
+    // HeaderMessage
+    QString protocolVersion;
+    QString clientName;
+    QString clientVersion;
+    QString clientDescription;
+
+    // RejectMessage
+    bool versionMismatch;
+    QString reason;
+
+    // MoveMessage, NotificationMessage
+    Coord field;
+    bool hit;
+    bool death;
+    Coord start;
+    Coord stop;
+
+    // GameOverMessage
+    QList<GameOverMessage::ShipInfo> ships;
+
+    // GameOptionsMessage
+    Coord board;
+    QList<unsigned int> fleet;
+    bool clientFirst;
+
+    MessageFields() { clear(); }
+    void clear();
+    void set(const QString& name, const QString& text);
+    MessagePtr build() const;
+};
+
+void MessageFields::clear()
+{
+    type = -1;
+    protocolVersion.clear();
+    clientName.clear();
+    clientVersion.clear();
+    clientDescription.clear();
+    versionMismatch = false;
+    reason.clear();
+    field = start = stop = board = Coord(0, 0);
+    hit = death = clientFirst = false;
+    ships.clear();
+    fleet.clear();
 }
 
-void Protocol::readMore()
+void MessageFields::set(const QString& name, const QString& text)
+{
+    if (name == "msgtype") {
+        bool ok;
+        type = text.toInt(&ok);
+        if (!ok) {
+            type = -1;
+        }
+    }
+    else if (name == "fieldx") {
+        field.x = text.toInt();
+    }
+    else if (name == "fieldy") {
+        field.y = text.toInt();
+    }
+    else if (name == "fieldstate") {
+        hit = text != "99";
+    }
+    else if (name == "death") {
+        death = text == "true";
+    }
+    else if (name == "xstart") {
+        start.x = text.toInt();
+    }
+    else if (name == "xstop") {
+        stop.x = text.toInt();
+    }
+    else if (name == "ystart") {
+        start.y = text.toInt();
+    }
+    else if (name == "ystop") {
+        stop.y = text.toInt();
+    }
+    else if (name.startsWith("ship")) {
+        QStringList data = text.split(' ');
+        if (data.size() == 3) {
+            int size = name.mid(4).toInt() + 1;
+            Coord pos(data[0].toInt(), data[1].toInt());
+            Ship::Direction direction = data[2] == QChar('0')
+                ? Ship::TOP_DOWN
+                : Ship::LEFT_TO_RIGHT;
+            ships.append(GameOverMessage::ShipInfo(pos, size, direction));
+        }
+    }
+    else if (name == "boardwidth") {
+        board.x = text.toInt();
+    }
+    else if (name == "boardheight") {
+        board.y = text.toInt();
+    }
+    else if (name == "fleet") {
+        foreach (const QString& ship, text.split(' ', QString::SkipEmptyParts)) {
+            fleet.append(ship.toUInt());
+        }
+    }
+    else if (name == "clientfirst") {
+        clientFirst = text == "true";
+    }
+    else if (name == "protocolVersion") {
+        protocolVersion = text;
+    }
+    else if (name == "clientName") {
+        clientName = text;
+    }
+    else if (name == "clientVersion") {
+        clientVersion = text;
+    }
+    else if (name == "clientDescription") {
+        clientDescription = text;
+    }
+    else if (name == "kmversion") {
+        versionMismatch = text == "true";
+    }
+    else if (name == "reason") {
+        reason = text;
+    }
+}
+
+MessagePtr MessageFields::build() const
 {
-    QByteArray data = m_device->readAll();
-    m_buffer += QString::fromUtf8(data.constData());
+    switch (type) {
+    case HeaderMessage::MSGTYPE:
+        return MessagePtr(new HeaderMessage(protocolVersion, clientName,
+                                            clientVersion, clientDescription));
+    case RejectMessage::MSGTYPE:
+        return MessagePtr(new RejectMessage(versionMismatch, reason));
+    case BeginMessage::MSGTYPE:
+        return MessagePtr(new BeginMessage);
+    case MoveMessage::MSGTYPE:
+        return MessagePtr(new MoveMessage(field));
+    case NotificationMessage::MSGTYPE:
+        if (death) {
+            return MessagePtr(new NotificationMessage(field, hit, death, start, stop));
+        }
+        else {
+            return MessagePtr(new NotificationMessage(field, hit, death));
+        }
+    case GameOverMessage::MSGTYPE:
+        {
+            GameOverMessage* msg = new GameOverMessage;
+            foreach (const GameOverMessage::ShipInfo& ship, ships) {
+                msg->addShip(ship.pos, ship.size, ship.direction);
+            }
+            return MessagePtr(msg);
+        }
+    case RestartMessage::MSGTYPE:
+        return MessagePtr(new RestartMessage());
+    case GameOptionsMessage::MSGTYPE:
+        return MessagePtr(new GameOptionsMessage(GameSettings(board, fleet), clientFirst));
+    default:
+        return MessagePtr();
+    }
+}
 
-    int pos;
-    while ((pos = m_buffer.indexOf("</kmessage>")) >= 0) {
-        pos += 11; // Length of "</kmessage>"
-        MessagePtr msg = parseMessage(m_buffer.left(pos));
-        m_buffer.remove(0, pos);
+// a binary frame starts with a byte that never occurs in UTF-8 text,
+// followed by the message type and the payload length on 16 bits
+static const int FRAME_MARKER = 0xff;
+static const int FRAME_HEADER = 4;
 
-        emit received(msg);
+// flags of a NotificationMessage frame
+static const int NOTIFICATION_HIT = 1;
+static const int NOTIFICATION_DEATH = 2;
+
+// bytes given to the reader at a time
+static const int SLICE = 1024;
+
+// longest document accepted, far above any legitimate message
+static const int MAX_DOCUMENT = 64 * 1024;
+
+// bytes the device may still hold before messages are held back
+static const qint64 MAX_BUFFERED = 64 * 1024;
+
+/**
+ * @return the largest position between begin and end that does not
+ *         split a UTF-8 character of data
+ */
+static int characterBoundary(const QByteArray& data, int begin, int end)
+{
+    int lead = end - 1;
+    while (lead > begin && (uchar(data[lead]) & 0xc0) == 0x80) {
+        lead--;
+    }
+    if (lead < begin) {
+        return end;
     }
+
+    uchar c = data[lead];
+    int length = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+    return lead + length <= end ? end : lead;
+}
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
-#define DEF_ELEMENT(var) QString var = main.namedItem(#var).toElement().text()
-#define DEF_COORD(var, varx, vary) DEF_ELEMENT(varx); DEF_ELEMENT(vary); Coord var(varx.toInt(), vary.toInt());
-MessagePtr Protocol::parseMessage(const QString& xmlMessage)
+/**
+ * Encodes messages as binary frames. Coordinates, sizes and counts
+ * take a byte each, strings are UTF-8 preceded by their length on a
+ * byte, and the 16 bit payload length is big endian.
+ */
+class BinarySender : public MessageVisitor
 {
-    qDebug() << "received:" << xmlMessage;
+    QByteArray m_frame;
 
-    QDomDocument doc;
-    doc.setContent(xmlMessage);
+    void addByte(int value) { m_frame.append(char(value)); }
 
-    QDomElement main = doc.documentElement();
-    if (main.tagName() != "kmessage")
+    void addCoord(const Coord& c)
     {
-        emit parseError("Invalid parent tag");
-        return MessagePtr();
+        addByte(c.x);
+        addByte(c.y);
     }
 
-    QDomElement msgtype = main.namedItem("msgtype").toElement();
-    if (msgtype.isNull())
+    void addString(const QString& value)
     {
-        emit parseError("No message type");
-        return MessagePtr();
+        QByteArray utf8 = value.toUtf8();
+        utf8.truncate(characterBoundary(utf8, 0, qMin(utf8.size(), 0xff)));
+        addByte(utf8.size());
+        m_frame += utf8;
+    }
+
+    template <typename Msg>
+    void setType(const Msg&)
+    {
+        addByte(FRAME_MARKER);
+        addByte(Msg::MSGTYPE);
+        addByte(0);
+        addByte(0);
+    }
+public:
+    QByteArray frame() const
+    {
+        QByteArray res = m_frame;
+        int length = res.size() - FRAME_HEADER;
+        res[2] = char(length >> 8);
+        res[3] = char(length);
+        return res;
+    }
+
+    virtual void visit(const HeaderMessage& msg)
+    {
+        setType(msg);
+        addString(msg.protocolVersion());
+        addString(msg.clientName());
+        addString(msg.clientVersion());
+        addString(msg.clientDescription());
+    }
+
+    virtual void visit(const RejectMessage& msg)
+    {
+        setType(msg);
+        addByte(msg.versionMismatch() ? 1 : 0);
+        addString(msg.reason());
+    }
+
+    virtual void visit(const BeginMessage& msg) { setType(msg); }
+
+    virtual void visit(const MoveMessage& msg)
+    {
+        setType(msg);
+        addCoord(msg.move());
+    }
+
+    virtual void visit(const NotificationMessage& msg)
+    {
+        setType(msg);
+        addCoord(msg.move());
+        addByte((msg.hit() ? NOTIFICATION_HIT : 0) | (msg.death() ? NOTIFICATION_DEATH : 0));
+        if (msg.death()) {
+            addCoord(msg.start());
+            addCoord(msg.stop());
+        }
+    }
+
+    virtual void visit(const GameOverMessage& msg)
+    {
+        setType(msg);
+        addByte(msg.ships().size());
+        foreach (const GameOverMessage::ShipInfo &ship, msg.ships()) {
+            addCoord(ship.pos);
+            addByte(ship.size);
+            addByte(ship.direction == Ship::TOP_DOWN ? 1 : 0);
+        }
+    }
+
+    virtual void visit(const RestartMessage& msg) { setType(msg); }
+
+    virtual void visit(const GameOptionsMessage& msg)
+    {
+        setType(msg);
+        const GameSettings& settings = msg.settings();
+        addCoord(settings.size());
+        addByte(settings.fleet().size());
+        foreach (unsigned int ship, settings.fleet()) {
+            addByte(ship);
+        }
+        addByte(msg.clientFirst() ? 1 : 0);
+    }
+};
+
+/**
+ * Reads the payload of a binary frame. Reading past its end yields
+ * zeroes, and is reported by complete().
+ */
+class FrameReader
+{
+    const uchar* m_data;
+    int m_size;
+    int m_pos;
+public:
+    FrameReader(const char* data, int size)
+    : m_data(reinterpret_cast<const uchar*>(data))
+    , m_size(size)
+    , m_pos(0)
+    {
+    }
+
+    /**
+     * @return whether the payload has been read exactly
+     */
+    bool complete() const { return m_pos == m_size; }
+
+    int byte()
+    {
+        int res = m_pos < m_size ? m_data[m_pos] : 0;
+        m_pos++;
+        return res;
+    }
+
+    Coord coord()
+    {
+        int x = qint8(byte());
+        int y = qint8(byte());
+        return Coord(x, y);
     }
 
-    int type = msgtype.text().toInt();
+    QString string()
+    {
+        int length = byte();
+        QString res;
+        if (m_pos + length <= m_size) {
+            res = QString::fromUtf8(reinterpret_cast<const char*>(m_data) + m_pos, length);
+        }
+        m_pos += length;
+        return res;
+    }
+};
+
+static MessagePtr decodeFrame(int type, const char* data, int size)
+{
+    FrameReader reader(data, size);
+    MessageFields fields;
+    fields.type = type;
+
     switch (type) {
     case HeaderMessage::MSGTYPE:
-        {
-            DEF_ELEMENT(protocolVersion);
-            DEF_ELEMENT(clientName);
-            DEF_ELEMENT(clientVersion);
-            DEF_ELEMENT(clientDescription);
-            return MessagePtr(new HeaderMessage(protocolVersion, clientName,
-                                     clientVersion, clientDescription));
-        }
+        fields.protocolVersion = reader.string();
+        fields.clientName = reader.string();
+        fields.clientVersion = reader.string();
+        fields.clientDescription = reader.string();
+        break;
     case RejectMessage::MSGTYPE:
-        {
-            DEF_ELEMENT(kmversion);
-            DEF_ELEMENT(reason);
-            return MessagePtr(new RejectMessage(kmversion == "true", reason));
-        }
-    case BeginMessage::MSGTYPE:
-        return MessagePtr(new BeginMessage);
+        fields.versionMismatch = reader.byte() != 0;
+        fields.reason = reader.string();
+        break;
     case MoveMessage::MSGTYPE:
-        {
-            DEF_COORD(field, fieldx, fieldy);
-            return MessagePtr(new MoveMessage(field));
-        }
+        fields.field = reader.coord();
+        break;
     case NotificationMessage::MSGTYPE:
         {
-            DEF_COORD(field, fieldx, fieldy);
-            DEF_ELEMENT(fieldstate);
-            bool hit = fieldstate != "99";
-            DEF_ELEMENT(death);
-            bool destroyed = death == "true";
-            if (destroyed) {
-                DEF_COORD(start, xstart, ystart);
-                DEF_COORD(stop, xstop, ystop);
-                return MessagePtr(new NotificationMessage(field, hit, destroyed, start, stop));
-            }
-            else {
-                return MessagePtr(new NotificationMessage(field, hit, destroyed));
+            fields.field = reader.coord();
+            int flags = reader.byte();
+            fields.hit = flags & NOTIFICATION_HIT;
+            fields.death = flags & NOTIFICATION_DEATH;
+            if (fields.death) {
+                fields.start = reader.coord();
+                fields.stop = reader.coord();
             }
         }
+        break;
     case GameOverMessage::MSGTYPE:
-        {
-            GameOverMessage* msg = new GameOverMessage;
-            QDomNodeList nodes = main.childNodes();
-            for (int i = 0; i < nodes.count(); i++) {
-                QDomElement element = nodes.item(i).toElement();
-                if (!element.isNull() && element.tagName().startsWith("ship")) {
-                    int size = element.tagName().mid(4).toInt() + 1;
-                    QStringList data = element.text().split(' ');
-                    if (data.size() != 3) {
-                        continue;
+        for (int n = reader.byte(); n > 0; n--) {
+            Coord pos = reader.coord();
+            int size = reader.byte();
+            Ship::Direction direction = reader.byte()
+                ? Ship::TOP_DOWN
+                : Ship::LEFT_TO_RIGHT;
+            fields.ships.append(GameOverMessage::ShipInfo(pos, size, direction));
+        }
+        break;
+    case GameOptionsMessage::MSGTYPE:
+        fields.board = reader.coord();
+        for (int n = reader.byte(); n > 0; n--) {
+            fields.fleet.append(reader.byte());
+        }
+        fields.clientFirst = reader.byte() != 0;
+        break;
+    default:
+        break;
+    }
+
+    if (!reader.complete()) {
+        return MessagePtr();
+    }
+    return fields.build();
+}
+
+/**
+ * Incremental decoder for a stream of kmessage documents and binary
+ * frames, which may be interleaved: the first byte of each message
+ * tells which one comes next.
+ *
+ * Data is added as it arrives, and the reader keeps its position and
+ * the fields read so far across calls, so every character is parsed
+ * once. Since each message is a document of its own, with its own
+ * DOCTYPE, a fresh reader takes over after each closing kmessage tag,
+ * starting where the previous one stopped. Readers are given the text
+ * in slices, so that a burst of messages is not copied again into the
+ * reader of each of them.
+ */
+class MessageDecoder
+{
+public:
+    enum Result
+    {
+        NEED_DATA,
+        MESSAGE,
+        INVALID_DATA
+    };
+private:
+    QXmlStreamReader m_reader;
+
+    // received bytes: the current message starts at m_begin
+    QByteArray m_pending;
+    int m_begin;
+
+    // whether a document is being read; the reader has then been
+    // given the bytes up to m_fed, the last slice of which is
+    // m_slice_bytes long, decoded into m_slice, and starts at
+    // character m_slice_offset of the document
+    bool m_xml;
+    int m_fed;
+    QString m_slice;
+    int m_slice_bytes;
+    int m_slice_offset;
+
+    int m_depth;
+    QString m_text;
+    MessageFields m_fields;
+
+    Result nextFrame(MessagePtr& msg, QString& error);
+    Result nextElement(MessagePtr& msg, QString& error);
+    void endDocument();
+    void compact();
+    void resync();
+public:
+    MessageDecoder();
+
+    void addData(const QByteArray& data);
+
+    /**
+     * Decode up to the end of the next message.
+     * @param msg the message, if MESSAGE is returned
+     * @param error a description of the problem, if INVALID_DATA is
+     *              returned; the decoder then skips to the next place
+     *              a message could start
+     */
+    Result next(MessagePtr& msg, QString& error);
+
+    /**
+     * @return the number of bytes received but not decoded yet
+     */
+    int buffered() const { return m_pending.size() - m_begin; }
+};
+
+MessageDecoder::MessageDecoder()
+: m_begin(0)
+, m_xml(false)
+, m_fed(0)
+, m_slice_bytes(0)
+, m_slice_offset(0)
+, m_depth(0)
+{
+}
+
+void MessageDecoder::addData(const QByteArray& data)
+{
+    m_pending += data;
+}
+
+void MessageDecoder::endDocument()
+{
+    // the reader may have looked at the token following the closing
+    // tag, never further than the end of the last slice
+    int end = m_reader.characterOffset() - m_slice_offset;
+    end = m_slice.lastIndexOf('>', end - 1) + 1;
+
+    // a slice of plain ASCII has a byte per character
+    if (m_slice.size() != m_slice_bytes) {
+        end = m_slice.left(end).toUtf8().size();
+    }
+
+    m_reader.clear();
+    m_begin = m_fed - m_slice_bytes + end;
+    m_xml = false;
+    m_depth = 0;
+}
+
+void MessageDecoder::compact()
+{
+    // drop the bytes of the messages already decoded
+    m_pending.remove(0, m_begin);
+    m_fed = m_xml ? m_fed - m_begin : 0;
+    m_begin = 0;
+}
+
+void MessageDecoder::resync()
+{
+    m_reader.clear();
+    m_xml = false;
+    m_depth = 0;
+
+    // drop the bytes up to the next document or frame, keeping what
+    // could be the beginning of one split across reads
+    static const QByteArray doctype("<!DOCTYPE");
+    static const QByteArray root("<kmessage");
+    int from = m_begin + 1;
+    int candidates[] = {
+        m_pending.indexOf(doctype, from),
+        m_pending.indexOf(root, from),
+        m_pending.indexOf(char(FRAME_MARKER), from)
+    };
+    int next = qMax(from, m_pending.size() - doctype.size() + 1);
+    for (int i = 0; i < 3; i++) {
+        if (candidates[i] != -1) {
+            next = qMin(next, candidates[i]);
+        }
+    }
+
+    m_begin = next;
+    compact();
+}
+
+MessageDecoder::Result MessageDecoder::next(MessagePtr& msg, QString& error)
+{
+    if (!m_xml) {
+        // skip the blank lines between messages
+        while (m_begin < m_pending.size() && isBlank(m_pending.at(m_begin))) {
+            m_begin++;
+        }
+        if (m_begin == m_pending.size()) {
+            compact();
+            return NEED_DATA;
+        }
+        if (uchar(m_pending[m_begin]) == FRAME_MARKER) {
+            return nextFrame(msg, error);
+        }
+
+        m_xml = true;
+        m_fed = m_begin;
+        m_slice.clear();
+        m_slice_bytes = 0;
+        m_slice_offset = 0;
+    }
+    return nextElement(msg, error);
+}
+
+MessageDecoder::Result MessageDecoder::nextFrame(MessagePtr& msg, QString& error)
+{
+    int available = m_pending.size() - m_begin;
+    const uchar* header = reinterpret_cast<const uchar*>(m_pending.constData()) + m_begin;
+    if (available < FRAME_HEADER
+        || available < FRAME_HEADER + (header[2] << 8 | header[3])) {
+        compact();
+        return NEED_DATA;
+    }
+
+    int length = header[2] << 8 | header[3];
+    msg = decodeFrame(header[1], m_pending.constData() + m_begin + FRAME_HEADER, length);
+    m_begin += FRAME_HEADER + length;
+    if (!msg) {
+        error = "Invalid binary message";
+        return INVALID_DATA;
+    }
+    return MESSAGE;
+}
+
+MessageDecoder::Result MessageDecoder::nextElement(MessagePtr& msg, QString& error)
+{
+    for (;;) {
+        while (!m_reader.atEnd()) {
+            switch (m_reader.readNext()) {
+            case QXmlStreamReader::StartElement:
+                m_depth++;
+                if (m_depth == 1) {
+                    if (m_reader.name() != QLatin1String("kmessage")) {
+                        error = "Invalid parent tag";
+                        resync();
+                        return INVALID_DATA;
                     }
-                    Coord pos(data[0].toInt(), data[1].toInt());
-                    Ship::Direction direction = data[2] == QChar('0')
-                        ? Ship::TOP_DOWN
-                        : Ship::LEFT_TO_RIGHT;
-                    msg->addShip(pos, size, direction);
+                    m_fields.clear();
+                }
+                m_text.clear();
+                break;
+            case QXmlStreamReader::Characters:
+                if (m_depth >= 2) {
+                    m_text += m_reader.text();
+                }
+                break;
+            case QXmlStreamReader::EndElement:
+                if (m_depth == 2) {
+                    m_fields.set(m_reader.name().toString(), m_text);
                 }
+                if (--m_depth == 0) {
+                    endDocument();
+                    if (m_fields.type == -1) {
+                        error = "No message type";
+                        return INVALID_DATA;
+                    }
+                    msg = m_fields.build();
+                    if (!msg) {
+                        error = "Unknown message type";
+                        return INVALID_DATA;
+                    }
+                    return MESSAGE;
+                }
+                break;
+            default:
+                // document start, DOCTYPE, comments
+                break;
             }
+        }
 
-            return MessagePtr(msg);
+        if (m_reader.hasError()
+            && m_reader.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+            error = m_reader.errorString();
+            resync();
+            return INVALID_DATA;
         }
-    case RestartMessage::MSGTYPE:
-        return MessagePtr(new RestartMessage());
-    default:
-        emit parseError("Unknown message type");
-        return MessagePtr();
+
+        if (m_fed - m_begin >= MAX_DOCUMENT) {
+            error = "Message too long";
+            resync();
+            return INVALID_DATA;
+        }
+
+        // slices end on a character boundary, so that each of them
+        // can be decoded on its own
+        int end = characterBoundary(m_pending, m_fed,
+                                    qMin(m_fed + SLICE, m_pending.size()));
+        if (end == m_fed) {
+            compact();
+            return NEED_DATA;
+        }
+
+        m_slice_offset += m_slice.size();
+        m_slice = QString::fromUtf8(m_pending.constData() + m_fed, end - m_fed);
+        m_slice_bytes = end - m_fed;
+        m_reader.addData(m_slice);
+        m_fed = end;
     }
 }
-#undef DEF_COORD
-#undef DEF_ELEMENT
+
+Protocol::Protocol(QIODevice* device)
+: m_device(device)
+, m_decoder(new MessageDecoder)
+, m_binary(false)
+, m_flush_pending(false)
+{
+    m_device->setParent(this);
+    connect(m_device, SIGNAL(disconnected()), this, SLOT(processDisconnection()));
+    connect(m_device, SIGNAL(readyRead()), this, SLOT(readMore()));
+    connect(m_device, SIGNAL(bytesWritten(qint64)), this, SLOT(sendNext()));
+}
+
+Protocol::~Protocol()
+{
+    delete m_decoder;
+}
+
+void Protocol::readMore()
+{
+    m_decoder->addData(m_device->readAll());
+
+    MessagePtr msg;
+    QString error;
+    for (;;) {
+        switch (m_decoder->next(msg, error)) {
+        case MessageDecoder::MESSAGE:
+            {
+                // answer in the format the peer advertises
+                KSharedPtr<HeaderMessage> header = KSharedPtr<HeaderMessage>::dynamicCast(msg);
+                if (header) {
+                    m_binary = header->supportsBinary();
+                }
+            }
+            emit received(msg);
+            break;
+        case MessageDecoder::INVALID_DATA:
+            emit parseError(error);
+            break;
+        case MessageDecoder::NEED_DATA:
+            return;
+        }
+    }
+}
+
+int Protocol::bufferedBytes() const
+{
+    return m_decoder->buffered();
+}
 
 void Protocol::send(const MessagePtr& msg)
 {
     m_message_queue.enqueue(msg);
+
+    // messages sent from the same event are written together
+    if (!m_flush_pending) {
+        m_flush_pending = true;
+        QMetaObject::invokeMethod(this, "sendNext", Qt::QueuedConnection);
+    }
+}
+
+QByteArray Protocol::encode(const MessagePtr& msg) const
+{
+    if (m_binary) {
+        BinarySender sender;
+        msg->accept(sender);
+        return sender.frame();
+    }
+
+    MessageSender sender;
+    msg->accept(sender);
+    return sender.document().toString().toUtf8() + '\n';
 }
 
 void Protocol::sendNext()
 {
-    if (!m_message_queue.isEmpty())
-    {
-        MessageSender sender;
-        m_message_queue.dequeue()->accept(sender);
+    m_flush_pending = false;
 
-        QTextStream stream(m_device);
-        stream << sender.document().toString() << endl;
+    // wait for the device to drain: bytesWritten() brings us back
+    if (m_message_queue.isEmpty() || m_device->bytesToWrite() > MAX_BUFFERED) {
+        return;
+    }
 
-        qDebug() << "sending:" << sender.document().toString();
+    QByteArray data;
+    while (!m_message_queue.isEmpty()) {
+        data += encode(m_message_queue.dequeue());
     }
+    m_device->write(data);
 }
 
 void Protocol::processDisconnection()
 {
-    m_timer.stop();
+    m_message_queue.clear();
     emit disconnected();
 }
 
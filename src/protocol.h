@@ -12,25 +12,37 @@
 
 #include "message.h"
 
+#include <QObject>
 #include <QQueue>
 #include <QString>
-#include <QTimer>
 
+class MessageDecoder;
 class QIODevice;
 
 class Protocol : public QObject
 {
 Q_OBJECT
     QIODevice* m_device;
-    QString m_buffer;
+    MessageDecoder* m_decoder;
+
+    // whether messages are sent as binary frames rather than kmessage
+    // documents, which is the case once the peer has advertised them
+    bool m_binary;
     QQueue<MessagePtr> m_message_queue;
-    QTimer m_timer;
+    bool m_flush_pending;
 
-    MessagePtr parseMessage(const QString& xmlMessage);
+    QByteArray encode(const MessagePtr& msg) const;
 public:
     explicit Protocol(QIODevice* device);
+    ~Protocol();
 
     void send(const MessagePtr& msg);
+
+    /**
+     * @return the number of bytes received that do not make up a
+     *         whole message yet
+     */
+    int bufferedBytes() const;
 private slots:
     void readMore();
     void sendNext();
@@ -18,12 +18,13 @@
 #include "statswidget.h"
 #include "welcomescreen.h"
 
-#include <QMouseEvent>
 #include <QIcon>
+#include <QMouseEvent>
 
 
 SeaView::SeaView(QWidget* parent)
 : KGameCanvasWidget(parent)
+, m_grid_size(GameSettings().size())
 , m_delegate(0)
 , m_last_f(-1)
 {/*
@@ -53,11 +54,11 @@ SeaView::SeaView(QWidget* parent)
     m_labels[1]->show();
 
     // create fields
-    m_fields[0] = new BattleFieldView(this, m_renderer, "background", GRID_SIZE);
+    m_fields[0] = new BattleFieldView(this, m_renderer, "background", m_grid_size);
     m_fields[0]->stackUnder(m_screen);
     m_fields[0]->show();
     connect(m_fields[0]->screen(), SIGNAL(clicked(Button*)), this, SLOT(buttonClicked(Button*)));
-    m_fields[1] = new BattleFieldView(this, m_renderer, "background2", GRID_SIZE);
+    m_fields[1] = new BattleFieldView(this, m_renderer, "background2", m_grid_size);
     m_fields[1]->stackUnder(m_screen);
     m_fields[1]->show();
     connect(m_fields[1]->screen(), SIGNAL(clicked(Button*)), this, SLOT(buttonClicked(Button*)));
@@ -72,6 +73,14 @@ SeaView::SeaView(QWidget* parent)
     m_stats[1]->show();
 
 
+    // whatever the window ends up looking like, once it stops changing
+    m_prerender_timer.setSingleShot(true);
+    m_prerender_timer.setInterval(PRERENDER_DELAY);
+    connect(&m_prerender_timer, SIGNAL(timeout()), this, SLOT(prerender()));
+    m_resize_timer.setSingleShot(true);
+    m_resize_timer.setInterval(RESIZE_DELAY);
+    connect(&m_resize_timer, SIGNAL(timeout()), this, SLOT(resizeSettled()));
+
     Animator::instance()->start();
     update();
 
@@ -132,10 +141,33 @@ void SeaView::update()
     m_screen->moveTo(0, 0);
     m_screen->resize(QSize(m_fields[1]->pos().x() + m_fields[1]->size().width(),
                            m_fields[0]->size().height()));
+
+    m_prerender_timer.start();
+}
+
+void SeaView::setPrerenderSizes(const QList<int>& sizes)
+{
+    m_prerender_sizes = sizes;
+    m_prerender_timer.start();
+}
+
+void SeaView::prerender()
+{
+    m_renderer->prerender(QList<int>() << tileSize() << m_prerender_sizes, m_grid_size);
 }
 
 void SeaView::resizeEvent(QResizeEvent*)
 {
+    // stretch what is shown while the window is being dragged, and only
+    // render the size it is left at
+    m_renderer->setResizing(true);
+    m_resize_timer.start();
+    update();
+}
+
+void SeaView::resizeSettled()
+{
+    m_renderer->setResizing(false);
     update();
 }
 
@@ -310,6 +342,18 @@ void SeaView::clear()
     m_fields[1]->clear();
 }
 
+void SeaView::setGridSize(const Coord& size)
+{
+    if (size == m_grid_size) {
+        return;
+    }
+
+    m_grid_size = size;
+    m_fields[0]->setGridSize(size);
+    m_fields[1]->setGridSize(size);
+    update();
+}
+
 BattleFieldView* SeaView::otherField(BattleFieldView* field)
 {
     return field == m_fields[0] ? m_fields[1] : m_fields[0];
@@ -321,8 +365,8 @@ int SeaView::tileSize() const
         PlayerLabel::HEIGHT -
         LABEL_SPACING * 2 -
         StatsWidget::HEIGHT -
-        MARGIN * 2) / GRID_SIZE;
-    int w = (width() - GAP) / (GRID_SIZE * 2);
+        MARGIN * 2) / m_grid_size.y;
+    int w = (width() - GAP) / (m_grid_size.x * 2);
     return w < h ? w : h;
 }
 
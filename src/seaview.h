@@ -14,6 +14,9 @@
 #include "kgamecanvas.h"
 #include "sea.h"
 
+#include <QList>
+#include <QTimer>
+
 class BattleFieldView;
 class KBSRenderer;
 class Delegate;
@@ -26,11 +29,15 @@ class Stats;
 class SeaView : public KGameCanvasWidget
 {
 Q_OBJECT
-    static const unsigned int GRID_SIZE = 10;
     static const unsigned int LABEL_SPACING = 2;
     static const unsigned int MARGIN = 3;
     static const unsigned int GAP = 2;
+    // ms the tile size has to stay the same before it is prerendered
+    static const int PRERENDER_DELAY = 1000;
+    // ms without resize events before the elements are rendered again
+    static const int RESIZE_DELAY = 200;
 
+    Coord m_grid_size;
     WelcomeScreen* m_screen;
     BattleFieldView* m_fields[2];
     PlayerLabel* m_labels[2];
@@ -42,6 +49,10 @@ Q_OBJECT
     QPoint m_last_preview;
     int m_last_f;
 
+    QList<int> m_prerender_sizes;
+    QTimer m_prerender_timer;
+    QTimer m_resize_timer;
+
     bool setPreview(Sea::Player player, const QPoint& pos);
     bool updatePreview(const QPoint& pos);
     int fieldAt(const QPoint& p);
@@ -56,6 +67,7 @@ public:
     void miss(Sea::Player p, const Coord& c);
     void sink(Sea::Player p, const Coord& c, Ship* ship);
     void clear();
+    void setGridSize(const Coord& size);
 
     void setStats(Sea::Player p, const QString& icon,
                   const QString& text, Stats* stats);
@@ -66,6 +78,12 @@ public:
 
     void toggleLeftGrid(bool show);
     void toggleRightGrid(bool show);
+
+    /**
+     * Tile sizes to render every element at in the background, besides
+     * the current one, so that they are in the disk cache when needed.
+     */
+    void setPrerenderSizes(const QList<int>& sizes);
 protected:
     virtual void mouseMoveEvent(QMouseEvent*);
     virtual void mousePressEvent(QMouseEvent*);
@@ -78,6 +96,9 @@ public slots:
     void buttonClicked(Button*);
     void update();
     void rotate();
+private slots:
+    void prerender();
+    void resizeSettled();
 };
 
 #endif // SEA_H
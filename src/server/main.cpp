@@ -0,0 +1,65 @@
+/*
+ * Dedicated server: referees network games between remote clients.
+ *
+ * usage: battleship-server [-p port] [-j threads] [-b WxH] [-f fleet]
+ */
+
+#include "server.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+
+// the port clients connect to
+static const quint16 DEFAULT_PORT = 1234;
+
+static int usage()
+{
+    qWarning("usage: battleship-server [-p port] [-j threads] [-b WxH] [-f fleet]");
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    GameSettings settings;
+    quint16 port = DEFAULT_PORT;
+    int threads = QThread::idealThreadCount();
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-p" && i + 1 < args.size()) {
+            port = args[++i].toUShort();
+        }
+        else if (arg == "-j" && i + 1 < args.size()) {
+            threads = args[++i].toInt();
+        }
+        else if (arg == "-b" && i + 1 < args.size()) {
+            if (!settings.parseSize(args[++i])) {
+                return usage();
+            }
+        }
+        else if (arg == "-f" && i + 1 < args.size()) {
+            if (!settings.parseFleet(args[++i])) {
+                return usage();
+            }
+        }
+        else {
+            return usage();
+        }
+    }
+    if (port == 0 || threads < 1 || !settings.valid()) {
+        return usage();
+    }
+
+    Server server(settings, threads);
+    if (!server.listen(QHostAddress::Any, port)) {
+        qWarning("cannot listen on port %d: %s", port, qPrintable(server.errorString()));
+        return 1;
+    }
+    qWarning("listening on port %d, %d threads, %dx%d board", port, threads,
+             settings.size().x, settings.size().y);
+
+    return app.exec();
+}
@@ -0,0 +1,276 @@
+#include "match.h"
+
+#include "protocol.h"
+
+#include <QTcpSocket>
+
+Match::Match(int id, const GameSettings& settings, QTcpSocket* a, QTcpSocket* b,
+             QObject* parent)
+: QObject(parent)
+, m_id(id)
+, m_settings(settings)
+, m_sea(0)
+, m_connected(2)
+, m_closing(false)
+, m_from(Sea::NO_PLAYER)
+{
+    m_sockets[0] = a;
+    m_sockets[1] = b;
+    for (int p = 0; p < 2; p++) {
+        // the protocol takes the socket over
+        m_protocols[p] = new Protocol(m_sockets[p]);
+        m_protocols[p]->setParent(this);
+        connect(m_protocols[p], SIGNAL(received(MessagePtr)),
+                this, SLOT(received(MessagePtr)));
+        connect(m_protocols[p], SIGNAL(parseError(const QString&)),
+                this, SLOT(parseError(const QString&)));
+        connect(m_sockets[p], SIGNAL(disconnected()), this, SLOT(disconnected()));
+    }
+
+    restart();
+}
+
+Match::~Match()
+{
+    delete m_sea;
+}
+
+void Match::restart()
+{
+    delete m_sea;
+    m_sea = new Sea(m_settings);
+
+    m_options_sent = false;
+    m_shot_pending = false;
+    for (int p = 0; p < 2; p++) {
+        m_introduced[p] = false;
+        m_ready[p] = false;
+
+        // like any host, introduce ourselves; the options follow
+        // once both clients did
+        send(Sea::Player(p), new HeaderMessage);
+    }
+}
+
+void Match::sendOptions()
+{
+    // only clients that know about game options can play other ones
+    for (int p = 0; p < 2; p++) {
+        if (!m_options[p] && m_settings != GameSettings()) {
+            reject("Board size and fleet not supported by the client");
+            return;
+        }
+    }
+
+    // someone has to be told to move first
+    Sea::Player first = m_client_first[Sea::PLAYER_A] ? Sea::PLAYER_A : Sea::PLAYER_B;
+    if (!m_client_first[first]) {
+        reject("Playing on this server takes protocol version 0.3.0");
+        return;
+    }
+    if (m_sea->turn() != first) {
+        m_sea->switchTurn();
+    }
+
+    for (int p = 0; p < 2; p++) {
+        if (m_options[p]) {
+            send(Sea::Player(p), new GameOptionsMessage(m_settings, p == first));
+        }
+    }
+    m_options_sent = true;
+
+    // players that placed their ships early can now be announced
+    for (int p = 0; p < 2; p++) {
+        if (m_ready[p]) {
+            send(Sea::opponent(Sea::Player(p)), new BeginMessage);
+        }
+    }
+}
+
+void Match::send(Sea::Player player, Message* msg)
+{
+    m_protocols[player]->send(MessagePtr(msg));
+}
+
+void Match::reject(const QString& reason)
+{
+    for (int p = 0; p < 2; p++) {
+        send(Sea::Player(p), new RejectMessage(true, reason));
+    }
+    drop(reason);
+}
+
+void Match::drop(const QString& reason)
+{
+    if (m_closing) {
+        return;
+    }
+    m_closing = true;
+    qWarning("match %d: %s", m_id, qPrintable(reason));
+
+    // after the messages already sent
+    QMetaObject::invokeMethod(this, "close", Qt::QueuedConnection);
+}
+
+void Match::close()
+{
+    for (int p = 0; p < 2; p++) {
+        m_sockets[p]->disconnectFromHost();
+    }
+}
+
+void Match::disconnected()
+{
+    if (--m_connected > 0) {
+        // there is no way to tell a client its opponent left,
+        // other than leaving too
+        m_closing = true;
+        close();
+    }
+    else {
+        emit finished();
+        deleteLater();
+    }
+}
+
+Sea::Player Match::playerOf(QObject* object) const
+{
+    for (int p = 0; p < 2; p++) {
+        if (m_protocols[p] == object) {
+            return Sea::Player(p);
+        }
+    }
+    return Sea::NO_PLAYER;
+}
+
+void Match::received(MessagePtr msg)
+{
+    if (m_closing) {
+        return;
+    }
+
+    m_from = playerOf(sender());
+    Q_ASSERT(m_from != Sea::NO_PLAYER);
+    msg->accept(*this);
+}
+
+void Match::parseError(const QString& error)
+{
+    drop(QString("player %1 sent an invalid message: %2")
+        .arg(playerOf(sender())).arg(error));
+}
+
+void Match::visit(const HeaderMessage& msg)
+{
+    if (m_introduced[m_from] || m_sea->status() != Sea::PLACING_SHIPS) {
+        return;
+    }
+
+    m_introduced[m_from] = true;
+    m_options[m_from] = msg.supportsOptions();
+    m_client_first[m_from] = msg.supportsBinary();
+    if (m_introduced[Sea::opponent(m_from)]) {
+        sendOptions();
+    }
+}
+
+void Match::visit(const RejectMessage& msg)
+{
+    drop(QString("player %1 left: %2").arg(m_from).arg(msg.reason()));
+}
+
+void Match::visit(const BeginMessage&)
+{
+    if (m_ready[m_from] || m_sea->status() != Sea::PLACING_SHIPS) {
+        drop(QString("player %1 is not placing ships").arg(m_from));
+        return;
+    }
+
+    m_sea->add(m_from, m_settings.ships());
+    m_ready[m_from] = true;
+    if (m_options_sent) {
+        send(Sea::opponent(m_from), new BeginMessage);
+    }
+
+    if (m_ready[Sea::PLAYER_A] && m_ready[Sea::PLAYER_B]) {
+        m_sea->startPlaying();
+    }
+}
+
+void Match::visit(const MoveMessage& msg)
+{
+    if (m_shot_pending || !m_sea->canHit(m_from, msg.move())) {
+        drop(QString("player %1 made an illegal move").arg(m_from));
+        return;
+    }
+
+    m_shot_pending = true;
+    m_shot = msg.move();
+    send(Sea::opponent(m_from), new MoveMessage(m_shot));
+}
+
+void Match::visit(const NotificationMessage& msg)
+{
+    Sea::Player shooter = Sea::opponent(m_from);
+    if (!m_shot_pending || m_sea->turn() != shooter || msg.move() != m_shot) {
+        drop(QString("player %1 sent an unexpected notification").arg(m_from));
+        return;
+    }
+
+    HitInfo info = msg.hit() ? HitInfo::HIT : HitInfo::MISS;
+    if (msg.death()) {
+        // the sunk ship has to lie on the board, in a line,
+        // across the square that was shot
+        Coord delta = msg.stop() - msg.start();
+        Coord shipPos = (delta.x < 0 || delta.y < 0) ? msg.stop() : msg.start();
+        Coord shipEnd = (delta.x < 0 || delta.y < 0) ? msg.start() : msg.stop();
+        if (!msg.hit()
+            || !m_sea->valid(m_from, msg.start())
+            || !m_sea->valid(m_from, msg.stop())
+            || (delta.x != 0 && delta.y != 0)
+            || m_shot.x < shipPos.x || m_shot.x > shipEnd.x
+            || m_shot.y < shipPos.y || m_shot.y > shipEnd.y) {
+            drop(QString("player %1 sank an impossible ship").arg(m_from));
+            return;
+        }
+
+        int size = qAbs(delta.x) + qAbs(delta.y) + 1;
+        Ship::Direction direction = delta.x == 0 ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT;
+        info.shipDestroyed = new Ship(size, direction);
+        info.shipPos = shipPos;
+    }
+
+    m_shot_pending = false;
+    m_sea->forceHit(m_shot, info);
+    if (msg.death()) {
+        send(shooter, new NotificationMessage(m_shot, true, true, msg.start(), msg.stop()));
+    }
+    else {
+        send(shooter, new NotificationMessage(m_shot, msg.hit(), false));
+    }
+
+    if (m_sea->status() == Sea::A_WINS || m_sea->status() == Sea::B_WINS) {
+        for (int p = 0; p < 2; p++) {
+            send(Sea::Player(p), new GameOverMessage);
+        }
+        emit gameOver(m_sea->status() == Sea::A_WINS ? Sea::PLAYER_A : Sea::PLAYER_B);
+    }
+}
+
+void Match::visit(const GameOverMessage&)
+{
+
+}
+
+void Match::visit(const RestartMessage&)
+{
+    // the client asking for a new game introduces itself again,
+    // its opponent does too once it agrees
+    send(Sea::opponent(m_from), new RestartMessage);
+    restart();
+}
+
+void Match::visit(const GameOptionsMessage&)
+{
+    // only hosts choose the options
+}
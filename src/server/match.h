@@ -0,0 +1,80 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "message.h"
+#include "sea.h"
+
+#include <QObject>
+
+class Protocol;
+class QTcpSocket;
+
+/**
+ * Referee of the games between two remote clients.
+ *
+ * Each client sees the server as the host of a network game. The match
+ * keeps the authoritative Sea: it checks turns and moves, records hits
+ * and sunk ships from the notifications of the player being shot at,
+ * relays to each player what it is entitled to know, and decides when
+ * the game is over. As in any kmessage game, ship positions never leave
+ * the clients, so notifications are only checked for consistency.
+ *
+ * Clients expect the host to move first, so the first player has to be
+ * told otherwise, which takes protocol 0.3.0.
+ */
+class Match : public QObject, private MessageVisitor
+{
+Q_OBJECT
+    int m_id;
+    GameSettings m_settings;
+    Sea* m_sea;
+    QTcpSocket* m_sockets[2];
+    Protocol* m_protocols[2];
+    int m_connected;
+    bool m_closing;
+
+    // what each client told about itself in its header
+    bool m_introduced[2];
+    bool m_options[2];
+    bool m_client_first[2];
+
+    bool m_options_sent;
+    bool m_ready[2];
+    bool m_shot_pending;
+    Coord m_shot;
+
+    // the player whose message is being visited
+    Sea::Player m_from;
+
+    void restart();
+    void sendOptions();
+    void send(Sea::Player player, Message* msg);
+    void reject(const QString& reason);
+    void drop(const QString& reason);
+    Sea::Player playerOf(QObject* object) const;
+public:
+    Match(int id, const GameSettings& settings, QTcpSocket* a, QTcpSocket* b,
+          QObject* parent = 0);
+    ~Match();
+
+    inline int id() const { return m_id; }
+private slots:
+    void received(MessagePtr msg);
+    void parseError(const QString& error);
+    void disconnected();
+    void close();
+protected:
+    virtual void visit(const HeaderMessage& msg);
+    virtual void visit(const RejectMessage& msg);
+    virtual void visit(const BeginMessage& msg);
+    virtual void visit(const MoveMessage& msg);
+    virtual void visit(const NotificationMessage& msg);
+    virtual void visit(const GameOverMessage& msg);
+    virtual void visit(const RestartMessage& msg);
+    virtual void visit(const GameOptionsMessage& msg);
+signals:
+    void gameOver(int winner);
+    void finished();
+};
+
+#endif // MATCH_H
@@ -0,0 +1,113 @@
+#include "server.h"
+
+#include "shard.h"
+
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// seconds between two reports of the server load
+static const int REPORT_INTERVAL = 10;
+
+/**
+ * @return whether the peer of a connection that nobody reads from yet
+ *         has already closed it
+ */
+static bool closedByPeer(int socketDescriptor)
+{
+#ifdef Q_OS_UNIX
+    char c;
+    return ::recv(socketDescriptor, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0;
+#else
+    Q_UNUSED(socketDescriptor);
+    return false;
+#endif
+}
+
+static void closeDescriptor(int socketDescriptor)
+{
+#ifdef Q_OS_UNIX
+    ::close(socketDescriptor);
+#else
+    Q_UNUSED(socketDescriptor);
+#endif
+}
+
+Server::Server(const GameSettings& settings, int shards, QObject* parent)
+: QTcpServer(parent)
+, m_waiting(-1)
+, m_next_id(0)
+, m_matches(0)
+, m_games(0)
+{
+    Q_ASSERT(shards > 0);
+    for (int i = 0; i < shards; i++) {
+        QThread* thread = new QThread(this);
+        Shard* shard = new Shard(settings);
+        shard->moveToThread(thread);
+        connect(shard, SIGNAL(matchFinished()), this, SLOT(matchFinished()));
+        connect(shard, SIGNAL(gameOver()), this, SLOT(gameOver()));
+        thread->start();
+
+        m_threads.append(thread);
+        m_shards.append(shard);
+    }
+
+    connect(&m_report, SIGNAL(timeout()), this, SLOT(report()));
+    m_report.start(REPORT_INTERVAL * 1000);
+}
+
+Server::~Server()
+{
+    foreach (QThread* thread, m_threads) {
+        thread->quit();
+        thread->wait();
+    }
+    qDeleteAll(m_shards);
+    if (m_waiting != -1) {
+        closeDescriptor(m_waiting);
+    }
+}
+
+void Server::incomingConnection(int socketDescriptor)
+{
+    // nobody reads from a waiting client: make sure it did not leave
+    // before pairing it
+    if (m_waiting != -1 && closedByPeer(m_waiting)) {
+        closeDescriptor(m_waiting);
+        m_waiting = -1;
+    }
+
+    if (m_waiting == -1) {
+        m_waiting = socketDescriptor;
+        return;
+    }
+
+    int id = m_next_id++;
+    Shard* shard = m_shards[id % m_shards.size()];
+    QMetaObject::invokeMethod(shard, "startMatch", Qt::QueuedConnection,
+                              Q_ARG(int, id),
+                              Q_ARG(int, m_waiting),
+                              Q_ARG(int, socketDescriptor));
+    m_waiting = -1;
+    m_matches++;
+}
+
+void Server::matchFinished()
+{
+    m_matches--;
+}
+
+void Server::gameOver()
+{
+    m_games++;
+}
+
+void Server::report()
+{
+    qWarning("%d matches on %d threads, %d games over%s", m_matches, m_threads.size(),
+             m_games, m_waiting != -1 ? ", 1 client waiting" : "");
+}
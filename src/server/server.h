@@ -0,0 +1,42 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "gamesettings.h"
+
+#include <QList>
+#include <QTcpServer>
+#include <QTimer>
+
+class QThread;
+class Shard;
+
+/**
+ * Accepts clients, pairs them in the order they arrive, and hands each
+ * pair to the shard of its match id, which runs the match on its own
+ * thread from then on.
+ */
+class Server : public QTcpServer
+{
+Q_OBJECT
+    QList<QThread*> m_threads;
+    QList<Shard*> m_shards;
+
+    // the client waiting for an opponent, or -1
+    int m_waiting;
+
+    int m_next_id;
+    int m_matches;
+    int m_games;
+    QTimer m_report;
+protected:
+    virtual void incomingConnection(int socketDescriptor);
+public:
+    Server(const GameSettings& settings, int shards, QObject* parent = 0);
+    ~Server();
+private slots:
+    void matchFinished();
+    void gameOver();
+    void report();
+};
+
+#endif // SERVER_H
@@ -0,0 +1,36 @@
+# Headless server refereeing network games between remote clients.
+
+TEMPLATE = app
+QT = core network xml
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = battleship-server
+
+DEPENDPATH += . .. ../core
+INCLUDEPATH += . .. ../core
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+INSTALLDIR = $$(INSTALLDIR)
+isEmpty(INSTALLDIR) {
+    INSTALLDIR = $$(PWD)/rootfs/
+}
+target.path = $$INSTALLDIR/usr/bin
+INSTALLS += target
+
+HEADERS += ../protocol.h \
+           match.h \
+           server.h \
+           shard.h
+
+SOURCES += ../message.cpp \
+           ../protocol.cpp \
+           main.cpp \
+           match.cpp \
+           server.cpp \
+           shard.cpp
@@ -0,0 +1,38 @@
+#include "shard.h"
+
+#include "match.h"
+
+#include <QTcpSocket>
+
+#include <unistd.h>
+
+Shard::Shard(const GameSettings& settings)
+: m_settings(settings)
+{
+}
+
+void Shard::startMatch(int id, int first, int second)
+{
+    QTcpSocket* a = new QTcpSocket;
+    QTcpSocket* b = new QTcpSocket;
+    if (!a->setSocketDescriptor(first)) {
+        qWarning("match %d: %s", id, qPrintable(a->errorString()));
+        ::close(first);
+        ::close(second);
+    }
+    else if (!b->setSocketDescriptor(second)) {
+        // deleting a closes the descriptor it adopted
+        qWarning("match %d: %s", id, qPrintable(b->errorString()));
+        ::close(second);
+    }
+    else {
+        Match* match = new Match(id, m_settings, a, b, this);
+        connect(match, SIGNAL(gameOver(int)), this, SIGNAL(gameOver()));
+        connect(match, SIGNAL(finished()), this, SIGNAL(matchFinished()));
+        return;
+    }
+
+    delete a;
+    delete b;
+    emit matchFinished();
+}
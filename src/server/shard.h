@@ -0,0 +1,28 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "gamesettings.h"
+
+#include <QObject>
+
+/**
+ * The matches run by one worker thread. A shard lives in its thread,
+ * and so do the matches and sockets it creates.
+ */
+class Shard : public QObject
+{
+Q_OBJECT
+    GameSettings m_settings;
+public:
+    explicit Shard(const GameSettings& settings);
+public slots:
+    /**
+     * Start a match between two accepted connections.
+     */
+    void startMatch(int id, int first, int second);
+signals:
+    void matchFinished();
+    void gameOver();
+};
+
+#endif // SHARD_H
@@ -9,6 +9,7 @@
 
 #include "simplemenu.h"
 
+#include "aientity.h"
 #include "button.h"
 #include "clientnetworkdialog.h"
 #include "controller.h"
@@ -28,6 +29,7 @@
 
 const char* SimpleMenu::iconServer = ":/data/network-server.png";
 const char* SimpleMenu::iconClient = ":/data/network-connect.png";
+const char* SimpleMenu::iconComputer = ":/data/new-game.png";
 
 SimpleMenu::SimpleMenu(QWidget* parent, WelcomeScreen* screen)
 : QObject(parent)
@@ -43,12 +45,16 @@ SimpleMenu::SimpleMenu(QWidget* parent, WelcomeScreen* screen)
                                            tr("Host Game"));
         m_client_btn = m_screen->addButton(0, 1, QIcon(QLatin1String(iconClient)),
                                            tr("Connect to Game"));
+        m_computer_btn = m_screen->addButton(0, 2, QIcon(QLatin1String(iconComputer)),
+                                             tr("Play Against Computer"));
 
         // create connections
         connect(m_server_btn, SIGNAL(clicked()),
             this, SLOT(createServer()));
         connect(m_client_btn, SIGNAL(clicked()),
             this, SLOT(createClient()));
+        connect(m_computer_btn, SIGNAL(clicked()),
+            this, SLOT(createComputerGame()));
 
         // WiFi direct
         wpa = new Wpa;
@@ -101,6 +107,11 @@ void SimpleMenu::createServer()
         gameAbort();
 }
 
+void SimpleMenu::createComputerGame()
+{
+    finalize(DONE_COMPUTER, tr("Me"));
+}
+
 void SimpleMenu::gameAbort()
 {
     wpa->stopGroup();
@@ -147,6 +158,15 @@ void SimpleMenu::setupController(Controller* controller, Entity* old_opponent,
                       m_player2->stats());
         break;
     }
+    case DONE_COMPUTER: {
+        m_player1 = controller->createPlayer(Sea::Player(0), sea, m_nickname);
+        sea->setStats(Sea::Player(0), "score_mouse",
+                      m_nickname, m_player1->stats());
+        m_player2 = controller->createAI(Sea::Player(1));
+        sea->setStats(Sea::Player(1), "score_ai", tr("Computer"),
+                      m_player2->stats());
+        break;
+    }
     default:
         return;
     }
@@ -30,6 +30,7 @@ Q_OBJECT
 
     Button* m_server_btn;
     Button* m_client_btn;
+    Button* m_computer_btn;
 
     Protocol* m_protocol;
     QString m_nickname;
@@ -38,7 +39,8 @@ Q_OBJECT
     {
         READY,
         DONE_SERVER,
-        DONE_CLIENT
+        DONE_CLIENT,
+        DONE_COMPUTER
     } m_state;
 
     Entity* m_player1;
@@ -57,9 +59,11 @@ public:
 
     static const char* iconServer;
     static const char* iconClient;
+    static const char* iconComputer;
 public slots:
     void createServer();
     void createClient();
+    void createComputerGame();
     void gameAbort();
 private slots:
     void connectToHost(bool go);
@@ -11,12 +11,14 @@
 
 #include "kbsrenderer.h"
 
+#include <QTransform>
+
 Sprite::Sprite(KGameCanvasAbstract* parent, KBSRenderer* renderer, 
             const Coord& scale, const QString& name, bool rotated)
-: KGameCanvasPixmap(parent)
+: KGameCanvasRenderedPixmap(renderer->renderer(), name, parent)
 , m_scale(scale)
-, m_name(name)
 , m_rotated(rotated)
+, m_stretched(false)
 {
     update(renderer);
 }
@@ -27,15 +29,58 @@ Sprite::~Sprite()
 
 void Sprite::update(KBSRenderer* renderer)
 {
-    setPixmap(renderer->render(m_name, m_rotated, m_scale.x, m_scale.y));
+    // rotated elements are rendered lying, and turned once shown,
+    // so that both directions share their cache entries
+    QSize size = m_rotated ?
+        renderer->size(m_scale.y, m_scale.x) :
+        renderer->size(m_scale.x, m_scale.y);
+
+    if (renderer->isResizing() && !m_rendered.isNull()) {
+        // scaling is much cheaper than rendering, and no rendering is
+        // wasted on sizes that only last for a moment
+        if (m_rendered.size() != size || m_stretched) {
+            display(m_rendered.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+            m_stretched = m_rendered.size() != size;
+        }
+        return;
+    }
+
+    setRenderSize(size);
+    if (m_stretched && m_rendered.size() == size) {
+        // back at the size rendered last
+        display(m_rendered);
+        m_stretched = false;
+    }
+}
+
+void Sprite::setScale(const Coord& scale)
+{
+    m_scale = scale;
 }
 
 void Sprite::setName(const QString& name)
 {
-    m_name = name;
+    setSpriteKey(name);
 }
 
 QString Sprite::name() const
 {
-    return m_name;
+    return spriteKey();
+}
+
+void Sprite::display(const QPixmap& pixmap)
+{
+    if (m_rotated && !pixmap.isNull()) {
+        setPixmap(pixmap.transformed(QTransform().rotate(90)));
+    }
+    else {
+        setPixmap(pixmap);
+    }
+}
+
+void Sprite::receivePixmap(const QPixmap& pixmap)
+{
+    m_rendered = pixmap;
+    m_stretched = false;
+    display(pixmap);
 }
@@ -15,20 +15,42 @@
 
 class KBSRenderer;
 
-class Sprite : public KGameCanvasPixmap
+/**
+ * An element covering some tiles, whose pixmap is rendered by the
+ * KGameRenderer of a KBSRenderer. Changes of name and size show once
+ * the new pixmap is rendered, the old one is shown until then.
+ */
+class Sprite : public KGameCanvasRenderedPixmap
 {
     Coord m_scale;
-    QString m_name;
     bool m_rotated;
+    QPixmap m_rendered; // last pixmap received, unrotated
+    bool m_stretched;
 public:
     Sprite(KGameCanvasAbstract* parent, KBSRenderer* renderer,
             const Coord& scale, const QString& name, bool rotated);
 
     ~Sprite();
 
+    /**
+     * Follow the tile size of the renderer. While the renderer is
+     * resizing, the last pixmap rendered is stretched to the new size
+     * instead, until the sprite is updated again once it is not.
+     */
     void update(KBSRenderer* renderer);
+
+    /**
+     * Set the number of tiles covered, from the next update() on.
+     */
+    void setScale(const Coord& scale);
     void setName(const QString& name);
     QString name() const;
+protected:
+    /**
+     * Show a pixmap of the element, possibly stretched.
+     */
+    virtual void display(const QPixmap& pixmap);
+    virtual void receivePixmap(const QPixmap& pixmap);
 };
 
 #endif // SPRITE_H
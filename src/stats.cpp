@@ -16,9 +16,16 @@
 Stats::Stats()
 : m_hits(0)
 , m_misses(0)
+, m_targets(0)
 {
 }
 
+void Stats::setTargets(int targets)
+{
+    m_targets = targets;
+    emit targetsChanged();
+}
+
 int Stats::score() const
 {
     // Balancing factors
@@ -19,8 +19,15 @@ class Stats : public QObject
 Q_OBJECT
     int m_hits;
     int m_misses;
+    int m_targets;
 public:
     Stats();
+
+    /**
+     * Set the number of squares to hit to win.
+     */
+    void setTargets(int targets);
+    inline int targets() const { return m_targets; }
     
     inline int hits() const { return m_hits; }
     void addHit();
@@ -35,6 +42,7 @@ public:
 signals:
     void hitsChanged();
     void missesChanged();
+    void targetsChanged();
 };
 
 #endif // STATS_H
@@ -127,7 +127,11 @@ void StatsWidget::update()
 {
     if (m_stats) {
         m_elements[0]->setText(QString::number(m_stats->misses()));
-        m_elements[1]->setText(QString::number(m_stats->hits()));
+        QString hits = QString::number(m_stats->hits());
+        if (m_stats->targets() > 0) {
+            hits += '/' + QString::number(m_stats->targets());
+        }
+        m_elements[1]->setText(hits);
     }
     else {
         m_elements[0]->setText("0");
@@ -148,6 +152,7 @@ void StatsWidget::setData(Stats* stats)
     if (m_stats) {
         connect(m_stats, SIGNAL(hitsChanged()), this, SLOT(update()));
         connect(m_stats, SIGNAL(missesChanged()), this, SLOT(update()));
+        connect(m_stats, SIGNAL(targetsChanged()), this, SLOT(update()));
     }
     update();
 }
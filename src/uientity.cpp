@@ -33,6 +33,7 @@ void UIEntity::notify(Sea::Player player, const Coord& c, const HitInfo& info)
 void UIEntity::start(bool)
 {
     m_view->clear();
+    m_view->setGridSize(m_sea->size());
 }
 
 void UIEntity::hit(Shot* shot)
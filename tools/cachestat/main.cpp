@@ -0,0 +1,88 @@
+/*
+ * Prints the statistics of a KSharedDataCache, as kept in the cache
+ * file by every process using it.
+ *
+ * The cache is named as in the application, and is only attached to if
+ * it exists. Attaching to a cache of another version of the format
+ * deletes it, as the application would.
+ *
+ * usage: cachestat [-r] cache-name
+ *   -r  reset the statistics after printing them
+ */
+
+#include "kshareddatacache.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+static double ratio(quint64 part, quint64 whole)
+{
+    return whole > 0 ? double(part) / whole : 0;
+}
+
+static int usage(QTextStream& out)
+{
+    out << "usage: cachestat [-r] cache-name" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    bool reset = false;
+    QString name;
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-r") {
+            reset = true;
+        }
+        else if (!arg.startsWith('-') && name.isEmpty()) {
+            name = arg;
+        }
+        else {
+            return usage(out);
+        }
+    }
+    if (name.isEmpty()) {
+        return usage(out);
+    }
+
+    QString fileName = KSharedDataCache::cacheFileName(name);
+    if (!QFile::exists(fileName)) {
+        out << "no cache at " << fileName << endl;
+        return 1;
+    }
+
+    // an existing cache keeps its own size
+    KSharedDataCache cache(name, 0);
+    KSharedDataCache::Statistics stats = cache.statistics();
+    if (stats.pageSize == 0) {
+        out << "cannot lock the cache at " << fileName << endl;
+        return 1;
+    }
+
+    quint64 lookups = stats.hits + stats.misses;
+    out << fileName << endl
+        << "size " << cache.totalSize() << " bytes, " << cache.freeSize() << " free, pages of "
+        << stats.pageSize << " bytes" << endl
+        << stats.entries << " entries of " << stats.itemBytes << " bytes" << endl
+        << "lookups " << lookups << ": " << stats.hits << " hits, " << stats.misses << " misses ("
+        << ratio(stats.hits, lookups) * 100 << "% hits)" << endl
+        << "inserts " << stats.inserts << ", evictions " << stats.evictions
+        << ", collisions " << stats.collisions << endl
+        << "compactions " << stats.compactions << ", " << stats.pagesMoved << " pages moved" << endl
+        << "locked " << stats.lockCount << " times for " << stats.lockTime / 1000 << " us ("
+        << ratio(stats.lockTime, stats.lockCount) << " ns each)" << endl;
+
+    if (reset) {
+        cache.resetStatistics();
+        out << "statistics reset" << endl;
+    }
+
+    return 0;
+}
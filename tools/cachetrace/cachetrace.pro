@@ -0,0 +1,20 @@
+TEMPLATE = app
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+# the cache logs its every move
+DEFINES += QT_NO_DEBUG_OUTPUT
+TARGET = cachetrace
+
+DEPENDPATH += . ../../src
+INCLUDEPATH += . ../../src
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+HEADERS += ../../src/kshareddatacache.h \
+           ../../src/kshareddatacache_p.h
+
+SOURCES += ../../src/kshareddatacache.cpp \
+           main.cpp
@@ -0,0 +1,127 @@
+/*
+ * Replays a lookup trace against a KSharedDataCache, inserting every key
+ * that is missed, and prints the hit rate and the time taken by inserts.
+ *
+ * Keys are looked up with a Zipf distribution (s = 0.9) over 3000 keys of
+ * 1 to 13 KB, in a 2 MiB cache with pages of 4096 bytes. The trace only
+ * depends on the seed, so runs with different eviction policies, or of
+ * different versions of the cache, can be compared.
+ *
+ * usage: cachetrace [-p policy] [-s seed] [lookups]
+ *   -p  eviction policy: 0 none, 1 least recently used,
+ *       2 least often used, 3 oldest (default 0)
+ *   -s  seed of the trace (default 7)
+ */
+
+#include "kshareddatacache.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include <math.h>
+#include <stdlib.h>
+
+static const int KEYS = 3000;
+static const double EXPONENT = 0.9;
+static const unsigned CACHE_SIZE = 2 << 20;
+static const unsigned PAGE_SIZE = 4096;
+
+static QString keyOf(int k)
+{
+    return "sprite-" + QString::number(k);
+}
+
+static int valueSize(int k)
+{
+    return 1000 + (k * 7919) % 12000;
+}
+
+static int usage(QTextStream& out)
+{
+    out << "usage: cachetrace [-p policy] [-s seed] [lookups]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    int policy = 0;
+    unsigned seed = 7;
+    int lookups = 200000;
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        bool ok = true;
+        if (arg == "-p" && i + 1 < args.size()) {
+            policy = args[++i].toInt(&ok);
+            ok = ok && policy >= KSharedDataCache::NoEvictionPreference &&
+                 policy <= KSharedDataCache::EvictOldest;
+        }
+        else if (arg == "-s" && i + 1 < args.size()) {
+            seed = args[++i].toUInt(&ok);
+        }
+        else if (!arg.startsWith('-')) {
+            lookups = arg.toInt(&ok);
+            ok = ok && lookups > 0;
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            return usage(out);
+        }
+    }
+
+    // cumulative weights of the keys, the most popular first
+    QVector<double> weights(KEYS);
+    double sum = 0;
+    for (int k = 0; k < KEYS; k++) {
+        sum += 1.0 / pow(k + 1, EXPONENT);
+        weights[k] = sum;
+    }
+
+    QString name = "cachetrace-" + QString::number(app.applicationPid());
+    KSharedDataCache::deleteCache(name);
+    KSharedDataCache cache(name, CACHE_SIZE, PAGE_SIZE);
+    cache.setEvictionPolicy(KSharedDataCache::EvictionPolicy(policy));
+
+    srand(seed);
+    int hits = 0;
+    int inserts = 0;
+    qint64 total = 0;
+    qint64 worst = 0;
+    QElapsedTimer timer;
+    for (int n = 0; n < lookups; n++) {
+        double r = rand() / (RAND_MAX + 1.0) * sum;
+        int k = qLowerBound(weights.begin(), weights.end(), r) - weights.begin();
+
+        QByteArray data;
+        if (cache.find(keyOf(k), &data)) {
+            hits++;
+            continue;
+        }
+
+        data.fill('x', valueSize(k));
+        timer.start();
+        cache.insert(keyOf(k), data);
+        qint64 elapsed = timer.nsecsElapsed();
+        total += elapsed;
+        worst = qMax(worst, elapsed);
+        inserts++;
+    }
+
+    KSharedDataCache::deleteCache(name);
+
+    out << "policy " << policy << ": hit rate " << double(hits) / lookups
+        << ", " << inserts << " inserts, mean "
+        << (inserts > 0 ? total / 1000.0 / inserts : 0) << " us, worst "
+        << worst / 1000.0 << " us" << endl;
+
+    return 0;
+}
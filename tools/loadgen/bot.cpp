@@ -0,0 +1,190 @@
+#include "bot.h"
+
+#include "densitytargeter.h"
+#include "fleetplacer.h"
+#include "protocol.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+
+Bot::Bot(const QString& host, quint16 port, int delay, quint32 seed,
+         LoadStats* stats, QObject* parent)
+: QObject(parent)
+, m_socket(new QTcpSocket)
+, m_protocol(new Protocol(m_socket))
+, m_stats(stats)
+, m_delay(delay)
+, m_random(seed)
+, m_sea(0)
+, m_targeter(0)
+, m_shot_pending(false)
+{
+    // the protocol owns the socket
+    m_protocol->setParent(this);
+    connect(m_protocol, SIGNAL(received(MessagePtr)), this, SLOT(received(MessagePtr)));
+    connect(m_socket, SIGNAL(connected()), this, SLOT(connected()));
+    connect(m_socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    m_socket->connectToHost(host, port);
+}
+
+Bot::~Bot()
+{
+    delete m_targeter;
+    delete m_sea;
+}
+
+void Bot::connected()
+{
+    m_stats->connected++;
+    m_protocol->send(MessagePtr(new HeaderMessage));
+}
+
+void Bot::disconnected()
+{
+    m_stats->disconnected++;
+}
+
+void Bot::fail()
+{
+    m_socket->disconnectFromHost();
+}
+
+void Bot::received(MessagePtr msg)
+{
+    msg->accept(*this);
+}
+
+void Bot::newGame(const GameSettings& settings, bool first)
+{
+    delete m_targeter;
+    delete m_sea;
+    m_sea = new Sea(settings);
+    m_targeter = new DensityTargeter(settings.size(), settings.fleet(), m_random.next());
+    m_shot_pending = false;
+
+    if (!placeFleet(m_sea, Sea::PLAYER_A, settings.fleet(), m_random)) {
+        qWarning("cannot place the fleet");
+        fail();
+        return;
+    }
+    m_sea->add(Sea::PLAYER_B, settings.ships());
+    if (!first) {
+        m_sea->switchTurn();
+    }
+
+    m_protocol->send(MessagePtr(new BeginMessage));
+}
+
+void Bot::shootLater()
+{
+    QTimer::singleShot(m_delay, this, SLOT(shoot()));
+}
+
+void Bot::shoot()
+{
+    if (!m_sea || m_sea->status() != Sea::PLAYING
+        || m_sea->turn() != Sea::PLAYER_A || m_shot_pending) {
+        return;
+    }
+
+    m_shot = m_targeter->next();
+    m_shot_pending = true;
+    m_shot_timer.start();
+    m_protocol->send(MessagePtr(new MoveMessage(m_shot)));
+    m_stats->moves++;
+}
+
+void Bot::visit(const HeaderMessage&)
+{
+}
+
+void Bot::visit(const RejectMessage& msg)
+{
+    qWarning("rejected: %s", qPrintable(msg.reason()));
+    m_stats->rejected++;
+    fail();
+}
+
+void Bot::visit(const GameOptionsMessage& msg)
+{
+    if (!msg.settings().valid()) {
+        fail();
+        return;
+    }
+    newGame(msg.settings(), msg.clientFirst());
+}
+
+void Bot::visit(const BeginMessage&)
+{
+    // we are ready as soon as we know the options
+    if (!m_sea || m_sea->status() != Sea::PLACING_SHIPS) {
+        fail();
+        return;
+    }
+
+    m_sea->startPlaying();
+    if (m_sea->turn() == Sea::PLAYER_A) {
+        shootLater();
+    }
+}
+
+void Bot::visit(const NotificationMessage& msg)
+{
+    if (!m_shot_pending || msg.move() != m_shot) {
+        fail();
+        return;
+    }
+    m_shot_pending = false;
+    m_stats->latencies.append(m_shot_timer.nsecsElapsed() / 1000);
+
+    HitInfo info = msg.hit() ? HitInfo::HIT : HitInfo::MISS;
+    if (msg.death()) {
+        Coord delta = msg.stop() - msg.start();
+        info.shipDestroyed = new Ship(qAbs(delta.x) + qAbs(delta.y) + 1,
+                                      delta.x == 0 ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT);
+        info.shipPos = (delta.x < 0 || delta.y < 0) ? msg.stop() : msg.start();
+    }
+
+    // the sea takes the ship over
+    m_targeter->notify(m_shot, info);
+    m_sea->forceHit(m_shot, info);
+
+    // the loser asks for the next game, the winner waits for it
+}
+
+void Bot::visit(const MoveMessage& msg)
+{
+    if (!m_sea || !m_sea->canHit(Sea::PLAYER_B, msg.move())) {
+        fail();
+        return;
+    }
+
+    HitInfo info = m_sea->hit(msg.move());
+    bool hit = info.type == HitInfo::HIT;
+    if (info.shipDestroyed) {
+        Coord end = info.shipPos + info.shipDestroyed->increment() * (info.shipDestroyed->size() - 1);
+        m_protocol->send(MessagePtr(new NotificationMessage(msg.move(), hit, true, info.shipPos, end)));
+    }
+    else {
+        m_protocol->send(MessagePtr(new NotificationMessage(msg.move(), hit, false)));
+    }
+
+    if (m_sea->status() == Sea::B_WINS) {
+        m_stats->games++;
+        m_protocol->send(MessagePtr(new RestartMessage));
+        m_protocol->send(MessagePtr(new HeaderMessage));
+    }
+    else {
+        shootLater();
+    }
+}
+
+void Bot::visit(const GameOverMessage&)
+{
+}
+
+void Bot::visit(const RestartMessage&)
+{
+    // agree, as a client does by introducing itself again
+    m_protocol->send(MessagePtr(new HeaderMessage));
+}
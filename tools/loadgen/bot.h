@@ -0,0 +1,89 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "message.h"
+#include "random.h"
+#include "sea.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+class DensityTargeter;
+class Protocol;
+class QTcpSocket;
+
+/**
+ * What all the bots of a run have seen.
+ */
+struct LoadStats
+{
+    // Move to Notification round trips, in microseconds
+    QVector<qint64> latencies;
+
+    int connected;
+    int disconnected;
+    int rejected;
+    int games;
+    qint64 moves;
+
+    LoadStats()
+    : connected(0)
+    , disconnected(0)
+    , rejected(0)
+    , games(0)
+    , moves(0)
+    {
+    }
+};
+
+/**
+ * A client that plays game after game against whoever the server pairs
+ * it with: it places its fleet at random, shoots with a
+ * DensityTargeter at a fixed pace, and answers the moves of its
+ * opponent. The loser of each game asks for the next one.
+ */
+class Bot : public QObject, private MessageVisitor
+{
+Q_OBJECT
+    QTcpSocket* m_socket;
+    Protocol* m_protocol;
+    LoadStats* m_stats;
+    int m_delay;
+    Random m_random;
+
+    // the bot plays PLAYER_A, its opponent PLAYER_B
+    Sea* m_sea;
+    DensityTargeter* m_targeter;
+
+    bool m_shot_pending;
+    Coord m_shot;
+    QElapsedTimer m_shot_timer;
+
+    void newGame(const GameSettings& settings, bool first);
+    void shootLater();
+    void fail();
+public:
+    /**
+     * @param delay milliseconds between a turn starting and the shot
+     */
+    Bot(const QString& host, quint16 port, int delay, quint32 seed,
+        LoadStats* stats, QObject* parent = 0);
+    ~Bot();
+private slots:
+    void connected();
+    void disconnected();
+    void received(MessagePtr msg);
+    void shoot();
+protected:
+    virtual void visit(const HeaderMessage& msg);
+    virtual void visit(const RejectMessage& msg);
+    virtual void visit(const BeginMessage& msg);
+    virtual void visit(const MoveMessage& msg);
+    virtual void visit(const NotificationMessage& msg);
+    virtual void visit(const GameOverMessage& msg);
+    virtual void visit(const RestartMessage& msg);
+    virtual void visit(const GameOptionsMessage& msg);
+};
+
+#endif // BOT_H
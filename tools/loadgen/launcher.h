@@ -0,0 +1,53 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include "bot.h"
+
+#include <QTimer>
+
+// bots connected at a time, so that the listen backlog of the server
+// is not flooded
+static const int CONNECT_BATCH = 50;
+static const int CONNECT_INTERVAL = 10;
+
+/**
+ * Starts the bots a batch at a time.
+ */
+class Launcher : public QObject
+{
+Q_OBJECT
+    QString m_host;
+    quint16 m_port;
+    int m_bots;
+    int m_delay;
+    quint32 m_seed;
+    LoadStats* m_stats;
+    int m_started;
+    QTimer m_timer;
+public:
+    Launcher(const QString& host, quint16 port, int bots, int delay, quint32 seed,
+             LoadStats* stats)
+    : m_host(host)
+    , m_port(port)
+    , m_bots(bots)
+    , m_delay(delay)
+    , m_seed(seed)
+    , m_stats(stats)
+    , m_started(0)
+    {
+        connect(&m_timer, SIGNAL(timeout()), this, SLOT(launch()));
+        m_timer.start(CONNECT_INTERVAL);
+    }
+private slots:
+    void launch()
+    {
+        for (int i = 0; i < CONNECT_BATCH && m_started < m_bots; i++, m_started++) {
+            new Bot(m_host, m_port, m_delay, m_seed + m_started, m_stats, this);
+        }
+        if (m_started == m_bots) {
+            m_timer.stop();
+        }
+    }
+};
+
+#endif // LAUNCHER_H
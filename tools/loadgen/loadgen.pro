@@ -0,0 +1,24 @@
+TEMPLATE = app
+QT = core network xml
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = loadgen
+
+DEPENDPATH += . ../../src ../../src/core
+INCLUDEPATH += . ../../src ../../src/core
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+HEADERS += ../../src/protocol.h \
+           bot.h \
+           launcher.h
+
+SOURCES += ../../src/message.cpp \
+           ../../src/protocol.cpp \
+           bot.cpp \
+           main.cpp
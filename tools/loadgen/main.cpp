@@ -0,0 +1,104 @@
+/*
+ * Load generator for battleship-server.
+ *
+ * Connects bots to the server, which pairs them into matches, lets
+ * them play for a while, and reports the games played and the latency
+ * of Move to Notification round trips, which include the server and
+ * the opposing bot.
+ *
+ * usage: loadgen [-n bots] [-r moves/s] [-t seconds] [-s seed]
+ *                [host [port]]
+ */
+
+#include "launcher.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <QtAlgorithms>
+
+static qint64 percentile(const QVector<qint64>& sorted, double q)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    return sorted[qMin(sorted.size() - 1, int(q * sorted.size()))];
+}
+
+static int usage(QTextStream& out)
+{
+    out << "usage: loadgen [-n bots] [-r moves/s] [-t seconds] [-s seed] [host [port]]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    int bots = 1000;
+    double rate = 2;
+    int seconds = 30;
+    quint32 seed = 1;
+    QStringList address;
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-n" && i + 1 < args.size()) {
+            bots = args[++i].toInt();
+        }
+        else if (arg == "-r" && i + 1 < args.size()) {
+            rate = args[++i].toDouble();
+        }
+        else if (arg == "-t" && i + 1 < args.size()) {
+            seconds = args[++i].toInt();
+        }
+        else if (arg == "-s" && i + 1 < args.size()) {
+            seed = args[++i].toUInt();
+        }
+        else if (!arg.startsWith('-') && address.size() < 2) {
+            address << arg;
+        }
+        else {
+            return usage(out);
+        }
+    }
+    QString host = address.size() > 0 ? address[0] : QString("127.0.0.1");
+    quint16 port = address.size() > 1 ? address[1].toUShort() : 1234;
+    if (bots < 2 || rate < 0 || seconds < 1 || port == 0) {
+        return usage(out);
+    }
+    if (bots % 2 != 0) {
+        out << "bots are paired: give an even number of them" << endl;
+        return 1;
+    }
+
+    // a rate of 0 means as fast as possible
+    int delay = rate > 0 ? int(1000 / rate) : 0;
+
+    LoadStats stats;
+    Launcher launcher(host, port, bots, delay, seed, &stats);
+    QElapsedTimer timer;
+    timer.start();
+    QTimer::singleShot(seconds * 1000, &app, SLOT(quit()));
+    app.exec();
+
+    double elapsed = timer.nsecsElapsed() / 1e9;
+    out << bots << " bots, " << stats.connected << " connected, "
+        << stats.disconnected << " disconnected, " << stats.rejected << " rejected" << endl
+        << stats.games << " games, " << stats.moves << " moves in " << elapsed << " s ("
+        << stats.moves / elapsed << " moves/s)" << endl;
+
+    QVector<qint64> sorted = stats.latencies;
+    qSort(sorted);
+    out << "move to notification (us):"
+        << " p50 " << percentile(sorted, 0.5)
+        << " p90 " << percentile(sorted, 0.9)
+        << " p99 " << percentile(sorted, 0.99)
+        << " p99.9 " << percentile(sorted, 0.999)
+        << " max " << (sorted.isEmpty() ? 0 : sorted.last()) << endl;
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Microbenchmark for PlacementCounter.
+ *
+ * Compares every placement counting kernel built into this binary
+ * against the straightforward loop calling BattleField::canAddShip for
+ * every ship, direction and square, on random boards, and checks that
+ * they all agree.
+ *
+ * usage: placementbench [width [height [boards [rounds]]]]
+ */
+
+#include "battlefield.h"
+#include "placementcounter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+
+static const int FLEET[] = { 1, 2, 3, 4 };
+static const int FLEET_SIZE = sizeof(FLEET) / sizeof(FLEET[0]);
+
+struct Board
+{
+    QVector<quint64> miss;
+    QVector<quint64> sunk;
+    QVector<quint64> hit;
+};
+
+static Board randomBoard(const Coord& size)
+{
+    Board board;
+    board.miss.fill(0, size.y);
+    board.sunk.fill(0, size.y);
+    board.hit.fill(0, size.y);
+    for (int y = 0; y < size.y; y++)
+    for (int x = 0; x < size.x; x++) {
+        int r = qrand() % 100;
+        if (r < 30) {
+            board.miss[y] |= Q_UINT64_C(1) << x;
+        }
+        else if (r < 35) {
+            board.sunk[y] |= Q_UINT64_C(1) << x;
+        }
+    }
+    return board;
+}
+
+static QVector<int> remainingFleet()
+{
+    QVector<int> remaining(FLEET[FLEET_SIZE - 1] + 1, 0);
+    for (int i = 0; i < FLEET_SIZE; i++) {
+        remaining[FLEET[i]]++;
+    }
+    return remaining;
+}
+
+static BattleField* createBattleField(const Coord& size, const Board& board)
+{
+    BattleField* field = new BattleField(size);
+    for (Coord p(0, 0); p.y < size.y; p.y++)
+    for (p.x = 0; p.x < size.x; p.x++) {
+        if ((board.miss[p.y] >> p.x) & 1) {
+            field->forceHit(p, HitInfo::MISS);
+        }
+        else if ((board.sunk[p.y] >> p.x) & 1) {
+            field->forceHit(p, HitInfo::HIT);
+        }
+    }
+    return field;
+}
+
+// the reference: ask the battlefield about every placement
+static QVector<quint16> countWithBattleField(const Coord& size, const BattleField& field,
+                                             const QVector<int>& remaining)
+{
+    QVector<quint16> res(size.x * size.y, 0);
+    for (int s = 1; s < remaining.size(); s++) {
+        if (remaining[s] == 0) {
+            continue;
+        }
+        for (int d = 0; d < (s > 1 ? 2 : 1); d++) {
+            Ship::Direction direction = d == 0 ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT;
+            Coord inc = Ship::increment(direction);
+            for (Coord p(0, 0); p.y < size.y; p.y++)
+            for (p.x = 0; p.x < size.x; p.x++) {
+                if (field.canAddShip(p, s, direction)) {
+                    for (int i = 0; i < s; i++) {
+                        Coord c = p + inc * i;
+                        res[c.x + c.y * size.x] += remaining[s];
+                    }
+                }
+            }
+        }
+    }
+    return res;
+}
+
+static const char* kernelName(PlacementCounter::Kernel kernel)
+{
+    switch (kernel) {
+    case PlacementCounter::SCALAR:
+        return "scalar";
+    case PlacementCounter::SSE2:
+        return "sse2";
+    case PlacementCounter::AVX2:
+        return "avx2";
+    }
+    return "?";
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    Coord size(10, 10);
+    int boards = 1000;
+    int rounds = 100;
+    if (args.size() > 1) {
+        size.x = size.y = args[1].toInt();
+    }
+    if (args.size() > 2) {
+        size.y = args[2].toInt();
+    }
+    if (args.size() > 3) {
+        boards = args[3].toInt();
+    }
+    if (args.size() > 4) {
+        rounds = args[4].toInt();
+    }
+    if (size.x < 1 || size.y < 1 || size.x > PlacementCounter::MAX_WIDTH) {
+        out << "width must be between 1 and " << PlacementCounter::MAX_WIDTH << endl;
+        return 1;
+    }
+
+    qsrand(1);
+    QList<Board> samples;
+    for (int i = 0; i < boards; i++) {
+        samples.append(randomBoard(size));
+    }
+    QVector<int> remaining = remainingFleet();
+
+    out << "board " << size.x << "x" << size.y << ", "
+        << boards << " boards x " << rounds << " rounds" << endl;
+
+    // reference loop, only possible where the battlefield fits the board
+    QList<QVector<quint16> > expected;
+    if (size.y <= BitBoard::MAX_SIZE) {
+        QList<BattleField*> fields;
+        foreach (const Board& board, samples) {
+            fields.append(createBattleField(size, board));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < boards; i++) {
+                QVector<quint16> counts = countWithBattleField(size, *fields[i], remaining);
+                if (r == 0) {
+                    expected.append(counts);
+                }
+            }
+        }
+        double ns = double(timer.nsecsElapsed()) / (boards * rounds);
+        qDeleteAll(fields);
+        out << qSetFieldWidth(10) << left << "canAddShip" << reset
+            << ns << " ns/board" << endl;
+    }
+
+    for (int k = PlacementCounter::SCALAR; k <= PlacementCounter::AVX2; k++) {
+        PlacementCounter::Kernel kernel = PlacementCounter::Kernel(k);
+        if (!PlacementCounter::supported(kernel)) {
+            continue;
+        }
+
+        PlacementCounter counter(size);
+        counter.setKernel(kernel);
+
+        int mismatches = 0;
+        quint64 checksum = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < boards; i++) {
+                const Board& board = samples[i];
+                const QVector<quint16>& counts = counter.count(board.miss.constData(),
+                    board.sunk.constData(), board.hit.constData(), remaining);
+                checksum += counts[i % counts.size()];
+                if (r == 0 && !expected.isEmpty() && counts != expected[i]) {
+                    mismatches++;
+                }
+            }
+        }
+        double ns = double(timer.nsecsElapsed()) / (boards * rounds);
+
+        out << qSetFieldWidth(10) << left << kernelName(kernel) << reset
+            << ns << " ns/board";
+        if (!expected.isEmpty()) {
+            out << ", " << mismatches << " mismatches";
+        }
+        out << " (checksum " << checksum << ")" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+TEMPLATE = app
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = placementbench
+
+DEPENDPATH += . ../../src/core
+INCLUDEPATH += . ../../src/core
+
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+SOURCES += main.cpp
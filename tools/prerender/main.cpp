@@ -0,0 +1,97 @@
+/*
+ * Renders every element of a theme at the given tile sizes into its
+ * disk cache, as the game does in the background, so that a cache file
+ * can be shipped ready-made, e.g. in a device image.
+ *
+ * The cache is the one the game would use, in the home directory, and
+ * is copied to the output file if one is given. The game only uses a
+ * cache made from the same SVG file, wherever that file lies.
+ *
+ * usage: prerender [-b WIDTHxHEIGHT] [-c megabytes] [-o file] theme size...
+ */
+
+#include "gamesettings.h"
+#include "kbsrenderer.h"
+#include "kgamerenderer.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+static int usage(QTextStream& out)
+{
+    out << "usage: prerender [-b WIDTHxHEIGHT] [-c megabytes] [-o file] theme size..." << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    // no display needed, rendering is done on images
+    QApplication app(argc, argv, false);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    GameSettings settings;
+    unsigned cacheSize = KBSRenderer::CACHE_SIZE;
+    QString output;
+    QString theme;
+    QList<int> sizes;
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-b" && i + 1 < args.size()) {
+            if (!settings.parseSize(args[++i])) {
+                return usage(out);
+            }
+        }
+        else if (arg == "-c" && i + 1 < args.size()) {
+            cacheSize = args[++i].toUInt();
+        }
+        else if (arg == "-o" && i + 1 < args.size()) {
+            output = args[++i];
+        }
+        else if (!arg.startsWith('-') && theme.isEmpty()) {
+            theme = arg;
+        }
+        else if (!arg.startsWith('-') && arg.toInt() > 0) {
+            sizes << arg.toInt();
+        }
+        else {
+            return usage(out);
+        }
+    }
+    if (theme.isEmpty() || sizes.isEmpty() || cacheSize == 0) {
+        return usage(out);
+    }
+
+    KBSRenderer* renderer = new KBSRenderer(theme, cacheSize);
+    QElapsedTimer timer;
+    timer.start();
+    int started = renderer->prerender(sizes, settings.size());
+    QString cacheFile = renderer->renderer()->cacheFileName();
+    if (cacheFile.isEmpty()) {
+        out << "cannot load the theme " << theme << endl;
+        delete renderer;
+        return 1;
+    }
+    if (renderer->renderer()->isRendering()) {
+        QObject::connect(renderer->renderer(), SIGNAL(renderingFinished()), &app, SLOT(quit()));
+        app.exec();
+    }
+    out << started << " elements rendered in " << timer.nsecsElapsed() / 1e9 << " s into "
+        << cacheFile << endl;
+
+    // done with the cache
+    delete renderer;
+
+    if (!output.isEmpty()) {
+        QFile::remove(output);
+        if (!QFile::copy(cacheFile, output)) {
+            out << "cannot copy the cache to " << output << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+TEMPLATE = app
+QT = core gui svg
+CONFIG += console
+CONFIG -= app_bundle
+# the renderer and the cache log their every move
+DEFINES += QT_NO_DEBUG_OUTPUT
+TARGET = prerender
+
+DEPENDPATH += . ../../src ../../src/core
+INCLUDEPATH += . ../../src ../../src/core
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+HEADERS += ../../src/colorproxy_p.h \
+           ../../src/kbsrenderer.h \
+           ../../src/kgamerenderer.h \
+           ../../src/kgamerenderer_p.h \
+           ../../src/kgamerendererclient.h \
+           ../../src/kimagecache.h \
+           ../../src/kshareddatacache.h \
+           ../../src/kshareddatacache_p.h
+
+SOURCES += ../../src/colorproxy_p.cpp \
+           ../../src/kbsrenderer.cpp \
+           ../../src/kgamerenderer.cpp \
+           ../../src/kgamerendererclient.cpp \
+           ../../src/kimagecache.cpp \
+           ../../src/kshareddatacache.cpp \
+           main.cpp
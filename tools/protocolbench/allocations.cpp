@@ -0,0 +1,55 @@
+#include "allocations.h"
+
+#include <stddef.h>
+
+static quint64 s_count = 0;
+
+#ifdef __GLIBC__
+
+// interpose the allocator: the libraries, Qt included, resolve malloc
+// to these, which forward to the glibc implementation
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    s_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    s_count++;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    s_count++;
+    return __libc_realloc(ptr, size);
+}
+
+}
+
+bool allocationsCounted()
+{
+    return true;
+}
+
+#else
+
+bool allocationsCounted()
+{
+    return false;
+}
+
+#endif
+
+quint64 allocationCount()
+{
+    return s_count;
+}
@@ -0,0 +1,17 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <QtGlobal>
+
+/**
+ * @return whether heap allocations are counted in this build
+ */
+bool allocationsCounted();
+
+/**
+ * @return the number of calls to malloc, calloc and realloc so far,
+ *         which includes operator new and the buffers of Qt containers
+ */
+quint64 allocationCount();
+
+#endif // ALLOCATIONS_H
@@ -0,0 +1,51 @@
+#include "duplexdevice.h"
+
+#include <string.h>
+
+DuplexDevice::DuplexDevice()
+: m_peer(0)
+, m_written(0)
+{
+    open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+DuplexDevice::~DuplexDevice()
+{
+    if (m_peer) {
+        m_peer->m_peer = 0;
+        emit m_peer->disconnected();
+    }
+}
+
+void DuplexDevice::pair(DuplexDevice* a, DuplexDevice* b)
+{
+    Q_ASSERT(!a->m_peer && !b->m_peer);
+    a->m_peer = b;
+    b->m_peer = a;
+}
+
+qint64 DuplexDevice::bytesAvailable() const
+{
+    return m_buffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 DuplexDevice::readData(char* data, qint64 maxSize)
+{
+    int n = int(qMin<qint64>(maxSize, m_buffer.size()));
+    memcpy(data, m_buffer.constData(), n);
+    m_buffer.remove(0, n);
+    return n;
+}
+
+qint64 DuplexDevice::writeData(const char* data, qint64 size)
+{
+    if (!m_peer) {
+        return -1;
+    }
+
+    m_peer->m_buffer.append(data, int(size));
+    m_written += size;
+    emit m_peer->readyRead();
+    emit bytesWritten(size);
+    return size;
+}
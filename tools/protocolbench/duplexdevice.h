@@ -0,0 +1,41 @@
+#ifndef DUPLEXDEVICE_H
+#define DUPLEXDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+/**
+ * One end of an in-memory connection: what is written to it can be
+ * read from its peer.
+ *
+ * Data is delivered as soon as it is written, and the peer emits
+ * readyRead() from within write(), so every write is exactly one read
+ * on the other side, and callers decide where the stream is split.
+ */
+class DuplexDevice : public QIODevice
+{
+Q_OBJECT
+    DuplexDevice* m_peer;
+    QByteArray m_buffer;
+    qint64 m_written;
+public:
+    DuplexDevice();
+    ~DuplexDevice();
+
+    static void pair(DuplexDevice* a, DuplexDevice* b);
+
+    virtual bool isSequential() const { return true; }
+    virtual qint64 bytesAvailable() const;
+
+    /**
+     * @return the number of bytes written since the device was created
+     */
+    qint64 written() const { return m_written; }
+protected:
+    virtual qint64 readData(char* data, qint64 maxSize);
+    virtual qint64 writeData(const char* data, qint64 size);
+signals:
+    void disconnected();
+};
+
+#endif // DUPLEXDEVICE_H
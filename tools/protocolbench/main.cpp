@@ -0,0 +1,406 @@
+/*
+ * Benchmark and fuzzer for Protocol, over an in-memory connection.
+ *
+ * The benchmark sends every message type from one Protocol to another,
+ * as kmessage documents and as binary frames, and reports the bytes,
+ * time and heap allocations per message, encoding and decoding
+ * included.
+ *
+ * The fuzzer feeds a Protocol streams of valid messages, corrupted
+ * messages and garbage, split at random points, and checks that the
+ * decoder never buffers more than a message's worth of data and always
+ * recovers in time to deliver the valid messages that follow.
+ *
+ * usage: protocolbench [-n messages] [-b batch]
+ *        protocolbench -z streams [-s seed]
+ */
+
+#include "allocations.h"
+#include "duplexdevice.h"
+#include "protocol.h"
+#include "random.h"
+#include "receiver.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+
+// most bytes a decoder may hold between reads: a document just below
+// the size limit plus a slice, or the largest binary frame
+static const int MAX_BUFFERED = 64 * 1024 + 2 * 1024;
+
+// valid messages sent after the garbage of a fuzzed stream, enough to
+// get through the largest message the garbage may have announced
+static const int TAIL_BYTES = 3 * 64 * 1024;
+
+// the last message of a fuzzed stream
+static const Coord SENTINEL(42, 24);
+
+struct Sample
+{
+    QString name;
+    MessagePtr msg;
+
+    Sample(const QString& name, Message* msg)
+    : name(name)
+    , msg(msg)
+    {
+    }
+};
+
+static QList<Sample> samples()
+{
+    GameOverMessage* gameOver = new GameOverMessage;
+    QList<unsigned int> fleet = GameSettings().fleet();
+    for (int i = 0; i < fleet.size(); i++) {
+        gameOver->addShip(Coord(i, 2 * i), fleet[i], i % 2 ? Ship::TOP_DOWN : Ship::LEFT_TO_RIGHT);
+    }
+
+    QList<Sample> res;
+    res << Sample("header", new HeaderMessage)
+        << Sample("reject", new RejectMessage(false, "Game in progress"))
+        << Sample("begin", new BeginMessage)
+        << Sample("move", new MoveMessage(Coord(3, 7)))
+        << Sample("miss", new NotificationMessage(Coord(3, 7), false, false))
+        << Sample("sink", new NotificationMessage(Coord(3, 7), true, true, Coord(3, 5), Coord(3, 8)))
+        << Sample("gameover", gameOver)
+        << Sample("restart", new RestartMessage)
+        << Sample("options", new GameOptionsMessage(GameSettings()));
+    return res;
+}
+
+static MessagePtr header(bool binary)
+{
+    return MessagePtr(new HeaderMessage(binary ? "0.3.0" : "0.2.0",
+                                        "protocolbench", "1.0", ""));
+}
+
+static void deliver(Receiver& receiver, int messages)
+{
+    // writes are delivered at once, so a few rounds are enough
+    for (int i = 0; receiver.messages < messages; i++) {
+        if (i == 100) {
+            qFatal("protocolbench: %d messages lost", messages - receiver.messages);
+        }
+        QCoreApplication::processEvents();
+    }
+}
+
+/**
+ * Two Protocols talking to each other; the first one sends in the
+ * format chosen by the header it gets from the second.
+ */
+struct Connection
+{
+    DuplexDevice* local;
+    DuplexDevice* remote;
+    Protocol* sender;
+    Protocol* receiver;
+    Receiver replies;
+    Receiver received;
+
+    explicit Connection(bool binary)
+    : local(new DuplexDevice)
+    , remote(new DuplexDevice)
+    {
+        DuplexDevice::pair(local, remote);
+        sender = new Protocol(local);
+        receiver = new Protocol(remote);
+        QObject::connect(sender, SIGNAL(received(MessagePtr)), &replies, SLOT(received(MessagePtr)));
+        QObject::connect(receiver, SIGNAL(received(MessagePtr)), &received, SLOT(received(MessagePtr)));
+        QObject::connect(receiver, SIGNAL(parseError(const QString&)), &received, SLOT(parseError(const QString&)));
+
+        receiver->send(header(binary));
+        deliver(replies, 1);
+    }
+
+    ~Connection()
+    {
+        // the protocols own the devices
+        delete sender;
+        delete receiver;
+    }
+};
+
+static int bench(QTextStream& out, int messages, int batch)
+{
+    QList<Sample> list = samples();
+
+    out << "format  message   bytes     us/msg     msgs/s";
+    if (allocationsCounted()) {
+        out << "  allocs/msg";
+    }
+    out << endl;
+
+    for (int binary = 0; binary < 2; binary++) {
+        foreach (const Sample& sample, list) {
+            Connection connection(binary);
+
+            qint64 bytes = connection.local->written();
+            quint64 allocations = allocationCount();
+            QElapsedTimer timer;
+            timer.start();
+
+            for (int sent = 0; sent < messages; ) {
+                for (int i = 0; i < batch && sent < messages; i++, sent++) {
+                    connection.sender->send(sample.msg);
+                }
+                deliver(connection.received, sent);
+            }
+
+            double seconds = timer.nsecsElapsed() / 1e9;
+            allocations = allocationCount() - allocations;
+            bytes = connection.local->written() - bytes;
+
+            if (connection.received.errors > 0) {
+                out << sample.name << ": " << connection.received.errors << " errors" << endl;
+                return 1;
+            }
+
+            out << left
+                << qSetFieldWidth(8) << (binary ? "binary" : "xml")
+                << qSetFieldWidth(10) << sample.name
+                << right
+                << qSetFieldWidth(5) << bytes / messages
+                << qSetFieldWidth(11) << 1e6 * seconds / messages
+                << qSetFieldWidth(11) << qint64(messages / seconds);
+            if (allocationsCounted()) {
+                out << qSetFieldWidth(12) << double(allocations) / messages;
+            }
+            out << qSetFieldWidth(0) << endl;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Encodes messages by capturing what a Protocol writes.
+ */
+class Encoder
+{
+    DuplexDevice* m_local;
+    DuplexDevice* m_remote;
+    Protocol* m_protocol;
+public:
+    explicit Encoder(bool binary)
+    : m_local(new DuplexDevice)
+    , m_remote(new DuplexDevice)
+    , m_protocol(new Protocol(m_local))
+    {
+        DuplexDevice::pair(m_local, m_remote);
+        if (binary) {
+            // headers are always understood, whatever the format
+            Encoder xml(false);
+            m_remote->write(xml.encode(header(true)));
+        }
+    }
+
+    ~Encoder()
+    {
+        delete m_protocol;
+        delete m_remote;
+    }
+
+    QByteArray encode(const MessagePtr& msg)
+    {
+        m_protocol->send(msg);
+        QCoreApplication::processEvents();
+        return m_remote->readAll();
+    }
+};
+
+struct Fragment
+{
+    const char* data;
+    int size;
+};
+
+// sizes are explicit, fragments may hold NUL bytes
+#define FRAGMENT(text) { text, sizeof(text) - 1 }
+static const Fragment FRAGMENTS[] = {
+    FRAGMENT("<!DOCTYPE kmessage>"),
+    FRAGMENT("<kmessage>"),
+    FRAGMENT("</kmessage>"),
+    FRAGMENT("<msgtype>"),
+    FRAGMENT("</msgtype>"),
+    FRAGMENT("<msgtype>4</msgtype>"),
+    FRAGMENT("<fieldx>-1</fieldx>"),
+    FRAGMENT("<fieldy>99999999999</fieldy>"),
+    FRAGMENT("<kmessage><msgtype>"),
+    FRAGMENT("<notkmessage/>"),
+    FRAGMENT("<"),
+    FRAGMENT(">"),
+    FRAGMENT("&bogus;"),
+    FRAGMENT("<![CDATA["),
+    FRAGMENT("]]>"),
+    FRAGMENT("<!-- "),
+    FRAGMENT("\n\n\n"),
+    FRAGMENT("\xc3"),
+    FRAGMENT("\xe2\x82"),
+    FRAGMENT("\xff"),
+    FRAGMENT("\xff\x04"),
+    FRAGMENT("\xff\x04\x00\x02\x01"),
+    FRAGMENT("\xff\x04\xff\xff"),
+    FRAGMENT("\xff\x63\x00\x00"),
+    FRAGMENT("\xff\x06\x00\x01\xff")
+};
+#undef FRAGMENT
+static const int FRAGMENT_COUNT = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+
+static QByteArray garbage(Random& random, Encoder* encoders[2], const QList<Sample>& list)
+{
+    QByteArray res;
+    for (int n = 1 + random.bounded(20); n > 0; n--) {
+        QByteArray valid = encoders[random.bounded(2)]->encode(list[random.bounded(list.size())].msg);
+        switch (random.bounded(6)) {
+        case 0:
+            res += valid;
+            break;
+        case 1:
+            // truncated
+            res += valid.left(random.bounded(valid.size()));
+            break;
+        case 2:
+            // a few bytes changed
+            for (int i = 1 + random.bounded(4); i > 0; i--) {
+                valid[random.bounded(valid.size())] = char(random.next());
+            }
+            res += valid;
+            break;
+        case 3:
+            // a fragment spliced in
+            {
+                const Fragment& fragment = FRAGMENTS[random.bounded(FRAGMENT_COUNT)];
+                valid.insert(random.bounded(valid.size() + 1),
+                             QByteArray(fragment.data, fragment.size));
+            }
+            res += valid;
+            break;
+        case 4:
+            {
+                const Fragment& fragment = FRAGMENTS[random.bounded(FRAGMENT_COUNT)];
+                res.append(fragment.data, fragment.size);
+            }
+            break;
+        case 5:
+            for (int i = random.bounded(64); i > 0; i--) {
+                res += char(random.next());
+            }
+            break;
+        }
+    }
+    return res;
+}
+
+static int fuzz(QTextStream& out, int streams, quint32 seed)
+{
+    Random random(seed);
+    QList<Sample> list = samples();
+    Encoder xml(false);
+    Encoder binary(true);
+    Encoder* encoders[2] = { &xml, &binary };
+
+    qint64 bytes = 0;
+    qint64 reads = 0;
+    int errors = 0;
+    int largest = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int stream = 0; stream < streams; stream++) {
+        QByteArray data = garbage(random, encoders, list);
+        int tail = data.size() + TAIL_BYTES;
+        while (data.size() < tail) {
+            data += encoders[random.bounded(2)]->encode(list[random.bounded(list.size())].msg);
+        }
+        data += encoders[random.bounded(2)]->encode(MessagePtr(new MoveMessage(SENTINEL)));
+
+        DuplexDevice* local = new DuplexDevice;
+        DuplexDevice* remote = new DuplexDevice;
+        DuplexDevice::pair(local, remote);
+        Protocol protocol(remote);
+        Receiver receiver;
+        QObject::connect(&protocol, SIGNAL(received(MessagePtr)), &receiver, SLOT(received(MessagePtr)));
+        QObject::connect(&protocol, SIGNAL(parseError(const QString&)), &receiver, SLOT(parseError(const QString&)));
+
+        // mostly small reads, with the occasional large one
+        for (int pos = 0; pos < data.size(); ) {
+            int n = 1 + random.bounded(random.bounded(4) ? 16 : 8192);
+            n = qMin(n, data.size() - pos);
+            local->write(data.constData() + pos, n);
+            pos += n;
+            reads++;
+
+            largest = qMax(largest, protocol.bufferedBytes());
+            if (protocol.bufferedBytes() > MAX_BUFFERED) {
+                out << "stream " << stream << ": " << protocol.bufferedBytes()
+                    << " bytes buffered" << endl;
+                return 1;
+            }
+        }
+        bytes += data.size();
+        errors += receiver.errors;
+        delete local;
+
+        const MoveMessage* last = dynamic_cast<const MoveMessage*>(receiver.last.data());
+        if (!last || last->move() != SENTINEL || protocol.bufferedBytes() != 0) {
+            out << "stream " << stream << ": stalled after "
+                << receiver.messages << " messages, "
+                << protocol.bufferedBytes() << " bytes buffered" << endl;
+            return 1;
+        }
+    }
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    out << streams << " streams, " << bytes << " bytes in " << reads << " reads, "
+        << errors << " errors in " << seconds << " s" << endl
+        << "largest buffer: " << largest << " bytes" << endl;
+    return 0;
+}
+
+static int usage(QTextStream& out)
+{
+    out << "usage: protocolbench [-n messages] [-b batch]" << endl
+        << "       protocolbench -z streams [-s seed]" << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    int messages = 10000;
+    int batch = 1;
+    int streams = 0;
+    quint32 seed = 1;
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-n" && i + 1 < args.size()) {
+            messages = args[++i].toInt();
+        }
+        else if (arg == "-b" && i + 1 < args.size()) {
+            batch = args[++i].toInt();
+        }
+        else if (arg == "-z" && i + 1 < args.size()) {
+            streams = args[++i].toInt();
+        }
+        else if (arg == "-s" && i + 1 < args.size()) {
+            seed = args[++i].toUInt();
+        }
+        else {
+            return usage(out);
+        }
+    }
+    if (messages < 1 || batch < 1 || streams < 0) {
+        return usage(out);
+    }
+
+    if (streams > 0) {
+        return fuzz(out, streams, seed);
+    }
+    return bench(out, messages, batch);
+}
@@ -0,0 +1,26 @@
+TEMPLATE = app
+QT = core xml
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = protocolbench
+
+DEPENDPATH += . ../../src ../../src/core
+INCLUDEPATH += . ../../src ../../src/core
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+HEADERS += ../../src/protocol.h \
+           allocations.h \
+           duplexdevice.h \
+           receiver.h
+
+SOURCES += ../../src/message.cpp \
+           ../../src/protocol.cpp \
+           allocations.cpp \
+           duplexdevice.cpp \
+           main.cpp
@@ -0,0 +1,37 @@
+#ifndef RECEIVER_H
+#define RECEIVER_H
+
+#include "message.h"
+
+#include <QObject>
+
+/**
+ * Keeps count of what a Protocol delivers.
+ */
+class Receiver : public QObject
+{
+Q_OBJECT
+public:
+    int messages;
+    int errors;
+    MessagePtr last;
+
+    Receiver()
+    : messages(0)
+    , errors(0)
+    {
+    }
+public slots:
+    void received(MessagePtr msg)
+    {
+        messages++;
+        last = msg;
+    }
+
+    void parseError(const QString&)
+    {
+        errors++;
+    }
+};
+
+#endif // RECEIVER_H
@@ -0,0 +1,118 @@
+/*
+ * Self-play tournament between two shooting strategies.
+ *
+ * usage: tournament [-n games] [-j threads] [-s seed] [-b WxH] [-f fleet]
+ *                   [strategy strategy]
+ */
+
+#include "strategy.h"
+#include "worker.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+static int usage(QTextStream& out)
+{
+    out << "usage: tournament [-n games] [-j threads] [-s seed] [-b WxH] [-f fleet]"
+           " [strategy strategy]" << endl
+        << "strategies: " << Strategy::names().join(", ") << endl;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QTextStream out(stdout);
+
+    Match match;
+    match.seed = 1;
+
+    int games = 10000;
+    int threads = QThread::idealThreadCount();
+    for (int i = 1; i < args.size(); i++) {
+        const QString& arg = args[i];
+        if (arg == "-n" && i + 1 < args.size()) {
+            games = args[++i].toInt();
+        }
+        else if (arg == "-j" && i + 1 < args.size()) {
+            threads = args[++i].toInt();
+        }
+        else if (arg == "-s" && i + 1 < args.size()) {
+            match.seed = args[++i].toUInt();
+        }
+        else if (arg == "-b" && i + 1 < args.size()) {
+            if (!match.settings.parseSize(args[++i])) {
+                return usage(out);
+            }
+        }
+        else if (arg == "-f" && i + 1 < args.size()) {
+            if (!match.settings.parseFleet(args[++i])) {
+                return usage(out);
+            }
+        }
+        else if (Strategy::names().contains(arg) && match.strategies.size() < 2) {
+            match.strategies << arg;
+        }
+        else {
+            return usage(out);
+        }
+    }
+    if (match.strategies.isEmpty()) {
+        match.strategies << "density" << "hunt";
+    }
+    if (match.strategies.size() != 2 || games < 1 || threads < 1
+        || !match.settings.valid()) {
+        return usage(out);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // split the games evenly, workers steal from each other
+    // when they run out
+    QList<Worker*> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.append(new Worker(match, &workers, i,
+                                  qint64(games) * i / threads,
+                                  qint64(games) * (i + 1) / threads));
+    }
+    foreach (Worker* worker, workers) {
+        worker->start();
+    }
+
+    Results results;
+    foreach (Worker* worker, workers) {
+        worker->wait();
+        results += worker->results();
+    }
+    qDeleteAll(workers);
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+
+    const Coord& size = match.settings.size();
+    out << match.strategies[0] << " vs " << match.strategies[1] << " on "
+        << size.x << "x" << size.y << ": " << results.games << " games on "
+        << threads << " threads in " << seconds << " s (" << results.games / seconds << " games/s)" << endl;
+    if (results.unplaced > 0) {
+        out << "  " << results.unplaced << " games skipped, the fleet did not fit" << endl;
+    }
+    for (int p = 0; p < 2; p++) {
+        out << "  " << match.strategies[p] << ": "
+            << results.wins[p] << " wins ("
+            << 100.0 * results.wins[p] / results.games << "%), ";
+        if (results.wins[p] > 0) {
+            out << double(results.winningShots[p]) / results.wins[p] << " shots to win";
+        }
+        else {
+            out << "no wins";
+        }
+        if (results.forfeits[p] > 0) {
+            out << ", " << results.forfeits[p] << " forfeits";
+        }
+        out << endl;
+    }
+
+    return 0;
+}
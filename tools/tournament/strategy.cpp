@@ -0,0 +1,237 @@
+#include "strategy.h"
+
+#include "densitytargeter.h"
+#include "placementcounter.h"
+#include "random.h"
+
+#include <QVector>
+
+namespace {
+
+// Shoots at random squares.
+class RandomStrategy : public Strategy
+{
+    Coord m_size;
+    QVector<int> m_squares;
+    Random m_random;
+public:
+    RandomStrategy(const Coord& size, quint32 seed)
+    : m_size(size)
+    , m_squares(size.x * size.y)
+    , m_random(seed)
+    {
+        for (int i = 0; i < m_squares.size(); i++) {
+            m_squares[i] = i;
+        }
+    }
+
+    virtual Coord next()
+    {
+        // draw without replacement
+        int k = m_random.bounded(m_squares.size());
+        int i = m_squares[k];
+        m_squares[k] = m_squares.last();
+        m_squares.pop_back();
+        return Coord(i % m_size.x, i / m_size.x);
+    }
+
+    virtual void notify(const Coord&, const HitInfo&) { }
+};
+
+// Shoots at random until something is hit, then tries the
+// neighbours of every open hit.
+class HuntStrategy : public Strategy
+{
+    Coord m_size;
+    QVector<bool> m_shot;
+    QList<Coord> m_targets;
+    Random m_random;
+public:
+    HuntStrategy(const Coord& size, quint32 seed)
+    : m_size(size)
+    , m_shot(size.x * size.y, false)
+    , m_random(seed)
+    {
+    }
+
+    virtual Coord next()
+    {
+        while (!m_targets.isEmpty()) {
+            Coord c = m_targets.takeLast();
+            if (!m_shot[c.x + c.y * m_size.x]) {
+                return c;
+            }
+        }
+
+        int free = m_shot.count(false);
+        int k = m_random.bounded(free);
+        for (int i = 0; i < m_shot.size(); i++) {
+            if (!m_shot[i] && k-- == 0) {
+                return Coord(i % m_size.x, i / m_size.x);
+            }
+        }
+        return Coord::invalid();
+    }
+
+    virtual void notify(const Coord& c, const HitInfo& info)
+    {
+        m_shot[c.x + c.y * m_size.x] = true;
+        if (info.shipDestroyed) {
+            m_targets.clear();
+        }
+        else if (info.type == HitInfo::HIT) {
+            const Coord steps[] = { Coord(1, 0), Coord(-1, 0), Coord(0, 1), Coord(0, -1) };
+            for (int i = 0; i < 4; i++) {
+                Coord p = c + steps[i];
+                if (p.x >= 0 && p.x < m_size.x && p.y >= 0 && p.y < m_size.y) {
+                    m_targets.append(p);
+                }
+            }
+        }
+    }
+};
+
+// Incremental placement density, see DensityTargeter.
+class DensityStrategy : public Strategy
+{
+    DensityTargeter m_targeter;
+public:
+    DensityStrategy(const Coord& size, const QList<unsigned int>& fleet, quint32 seed)
+    : m_targeter(size, fleet, seed)
+    {
+    }
+
+    virtual Coord next() { return m_targeter.next(); }
+    virtual void notify(const Coord& c, const HitInfo& info) { m_targeter.notify(c, info); }
+};
+
+// Placement density recomputed from scratch with PlacementCounter;
+// while some ship is hit, only squares next to the open hits are
+// considered.
+class KernelStrategy : public Strategy
+{
+    Coord m_size;
+    PlacementCounter m_counter;
+    QVector<quint64> m_miss;
+    QVector<quint64> m_sunk;
+    QVector<quint64> m_hit;
+    QVector<int> m_remaining;
+    int m_open_hits;
+    Random m_random;
+
+    inline bool test(const QVector<quint64>& rows, const Coord& c) const
+    {
+        return (rows[c.y] >> c.x) & 1;
+    }
+
+    bool nextToHit(const Coord& c) const
+    {
+        return (c.x > 0 && test(m_hit, c - Coord(1, 0)))
+            || (c.x < m_size.x - 1 && test(m_hit, c + Coord(1, 0)))
+            || (c.y > 0 && test(m_hit, c - Coord(0, 1)))
+            || (c.y < m_size.y - 1 && test(m_hit, c + Coord(0, 1)));
+    }
+public:
+    KernelStrategy(const Coord& size, const QList<unsigned int>& fleet, quint32 seed)
+    : m_size(size)
+    , m_counter(size)
+    , m_miss(size.y, 0)
+    , m_sunk(size.y, 0)
+    , m_hit(size.y, 0)
+    , m_open_hits(0)
+    , m_random(seed)
+    {
+        foreach (unsigned int ship, fleet) {
+            if (int(ship) >= m_remaining.size()) {
+                m_remaining.resize(ship + 1);
+            }
+            m_remaining[ship]++;
+        }
+    }
+
+    virtual Coord next()
+    {
+        const QVector<quint16>& counts = m_counter.count(m_miss.constData(),
+            m_sunk.constData(), m_hit.constData(), m_remaining);
+
+        Coord res = Coord::invalid();
+        int best = -1;
+        int ties = 0;
+        for (Coord c(0, 0); c.y < m_size.y; c.y++)
+        for (c.x = 0; c.x < m_size.x; c.x++) {
+            if (test(m_miss, c) || test(m_sunk, c) || test(m_hit, c)) {
+                continue;
+            }
+            if (m_open_hits > 0 && !nextToHit(c)) {
+                continue;
+            }
+
+            int count = counts[c.x + c.y * m_size.x];
+            if (count > best) {
+                best = count;
+                ties = 1;
+                res = c;
+            }
+            else if (count == best && m_random.bounded(++ties) == 0) {
+                res = c;
+            }
+        }
+        return res;
+    }
+
+    virtual void notify(const Coord& c, const HitInfo& info)
+    {
+        quint64 bit = Q_UINT64_C(1) << c.x;
+        switch (info.type) {
+        case HitInfo::MISS:
+            m_miss[c.y] |= bit;
+            break;
+        case HitInfo::HIT:
+            m_hit[c.y] |= bit;
+            m_open_hits++;
+            if (info.shipDestroyed) {
+                Ship* ship = info.shipDestroyed;
+                Coord p = info.shipPos;
+                for (unsigned int i = 0; i < ship->size(); i++, p += ship->increment()) {
+                    quint64 b = Q_UINT64_C(1) << p.x;
+                    if (m_hit[p.y] & b) {
+                        m_hit[p.y] &= ~b;
+                        m_open_hits--;
+                    }
+                    m_sunk[p.y] |= b;
+                }
+                if (int(ship->size()) < m_remaining.size() && m_remaining[ship->size()] > 0) {
+                    m_remaining[ship->size()]--;
+                }
+            }
+            break;
+        case HitInfo::INVALID:
+            break;
+        }
+    }
+};
+
+}
+
+QStringList Strategy::names()
+{
+    return QStringList() << "random" << "hunt" << "density" << "kernel";
+}
+
+Strategy* Strategy::create(const QString& name, const Coord& size,
+                           const QList<unsigned int>& fleet, quint32 seed)
+{
+    if (name == "random") {
+        return new RandomStrategy(size, seed);
+    }
+    else if (name == "hunt") {
+        return new HuntStrategy(size, seed);
+    }
+    else if (name == "density") {
+        return new DensityStrategy(size, fleet, seed);
+    }
+    else if (name == "kernel") {
+        return new KernelStrategy(size, fleet, seed);
+    }
+    return 0;
+}
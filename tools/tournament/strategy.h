@@ -0,0 +1,25 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "coord.h"
+#include "hitinfo.h"
+
+#include <QList>
+#include <QStringList>
+
+/**
+ * A way of choosing shots, fed back with the outcome of each of them.
+ */
+class Strategy
+{
+public:
+    virtual ~Strategy() { }
+    virtual Coord next() = 0;
+    virtual void notify(const Coord& c, const HitInfo& info) = 0;
+
+    static QStringList names();
+    static Strategy* create(const QString& name, const Coord& size,
+                            const QList<unsigned int>& fleet, quint32 seed);
+};
+
+#endif // STRATEGY_H
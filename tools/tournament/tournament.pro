@@ -0,0 +1,22 @@
+TEMPLATE = app
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = tournament
+
+DEPENDPATH += . ../../src/core
+INCLUDEPATH += . ../../src/core
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+DESTDIR = ../../tmp
+
+LIBS += -L../../tmp -lbattleship-core
+PRE_TARGETDEPS += ../../tmp/libbattleship-core.a
+
+HEADERS += strategy.h \
+           worker.h
+
+SOURCES += main.cpp \
+           strategy.cpp \
+           worker.cpp
@@ -0,0 +1,152 @@
+#include "worker.h"
+
+#include "fleetplacer.h"
+#include "random.h"
+#include "strategy.h"
+
+Results::Results()
+: games(0)
+, unplaced(0)
+{
+    for (int i = 0; i < 2; i++) {
+        wins[i] = 0;
+        winningShots[i] = 0;
+        forfeits[i] = 0;
+    }
+}
+
+Results& Results::operator+=(const Results& other)
+{
+    games += other.games;
+    unplaced += other.unplaced;
+    for (int i = 0; i < 2; i++) {
+        wins[i] += other.wins[i];
+        winningShots[i] += other.winningShots[i];
+        forfeits[i] += other.forfeits[i];
+    }
+    return *this;
+}
+
+Worker::Worker(const Match& match, QList<Worker*>* workers, int id, int begin, int end)
+: m_match(match)
+, m_workers(workers)
+, m_id(id)
+, m_sea(0)
+, m_next(begin)
+, m_end(end)
+{
+}
+
+Worker::~Worker()
+{
+    delete m_sea;
+}
+
+bool Worker::takeGame(int* game)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_next < m_end) {
+        *game = m_next++;
+        return true;
+    }
+    return false;
+}
+
+bool Worker::giveHalf(int* begin, int* end)
+{
+    QMutexLocker lock(&m_mutex);
+    int left = m_end - m_next;
+    if (left <= 0) {
+        return false;
+    }
+
+    *end = m_end;
+    *begin = m_end - (left + 1) / 2;
+    m_end = *begin;
+    return true;
+}
+
+bool Worker::steal()
+{
+    int count = m_workers->size();
+    for (int i = 1; i < count; i++) {
+        Worker* victim = m_workers->at((m_id + i) % count);
+        int begin, end;
+        if (victim->giveHalf(&begin, &end)) {
+            QMutexLocker lock(&m_mutex);
+            m_next = begin;
+            m_end = end;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Worker::play(int game)
+{
+    if (m_sea) {
+        m_sea->reset(m_match.settings);
+    }
+    else {
+        m_sea = new Sea(m_match.settings);
+    }
+
+    Random random(m_match.seed + 2 * quint32(game));
+    Strategy* strategies[2];
+    bool placed = true;
+    for (int p = 0; p < 2; p++) {
+        placed = placeFleet(m_sea, Sea::Player(p), m_match.settings.fleet(), random) && placed;
+        strategies[p] = Strategy::create(m_match.strategies[p], m_match.settings.size(),
+                                         m_match.settings.fleet(), random.next());
+    }
+
+    // a game with ships missing would skew the results
+    if (!placed) {
+        m_results.unplaced++;
+        delete strategies[0];
+        delete strategies[1];
+        return;
+    }
+
+    // take turns at moving first
+    if (m_sea->turn() != Sea::Player(game % 2)) {
+        m_sea->switchTurn();
+    }
+    m_sea->startPlaying();
+
+    int shots[2] = { 0, 0 };
+    while (m_sea->status() == Sea::PLAYING) {
+        Sea::Player player = m_sea->turn();
+        Coord c = strategies[player]->next();
+        if (!m_sea->canHit(player, c)) {
+            m_results.forfeits[player]++;
+            m_sea->abort(Sea::opponent(player));
+            break;
+        }
+
+        HitInfo info = m_sea->hit(c);
+        shots[player]++;
+        strategies[player]->notify(c, info);
+    }
+
+    Sea::Player winner = m_sea->status() == Sea::A_WINS ? Sea::PLAYER_A : Sea::PLAYER_B;
+    m_results.games++;
+    m_results.wins[winner]++;
+    m_results.winningShots[winner] += shots[winner];
+
+    delete strategies[0];
+    delete strategies[1];
+}
+
+void Worker::run()
+{
+    int game;
+    for (;;) {
+        if (takeGame(&game)) {
+            play(game);
+        }
+        else if (!steal()) {
+            break;
+        }
+    }
+}
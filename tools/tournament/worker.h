@@ -0,0 +1,64 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "sea.h"
+
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+
+struct Match
+{
+    QStringList strategies; // indexed by Sea::Player
+    GameSettings settings;
+    quint32 seed;
+};
+
+struct Results
+{
+    int games;
+    int unplaced; // games skipped because a fleet did not fit
+    int wins[2];
+    qint64 winningShots[2];
+    int forfeits[2];
+
+    Results();
+    Results& operator+=(const Results& other);
+};
+
+/**
+ * Plays games of a match on its own thread, with its own Sea.
+ *
+ * Each worker starts with a range of game numbers. When its range is
+ * exhausted it steals the upper half of the range of another worker,
+ * and it stops when no worker has games left. Games are seeded from
+ * their number, so results do not depend on the scheduling.
+ */
+class Worker : public QThread
+{
+Q_OBJECT
+    const Match& m_match;
+    QList<Worker*>* m_workers;
+    int m_id;
+    Sea* m_sea;
+    Results m_results;
+
+    QMutex m_mutex;
+    int m_next;
+    int m_end;
+
+    bool takeGame(int* game);
+    bool giveHalf(int* begin, int* end);
+    bool steal();
+    void play(int game);
+public:
+    Worker(const Match& match, QList<Worker*>* workers, int id, int begin, int end);
+    ~Worker();
+
+    const Results& results() const { return m_results; }
+protected:
+    virtual void run();
+};
+
+#endif // WORKER_H